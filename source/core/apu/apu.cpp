@@ -30,14 +30,17 @@ void APU::Reset() {
   averaged_sample = 0.0f;
 }
 
-void APU::Step() {
-  averaged_sample += (psg1.sample / 128.0f + psg2.sample / 128.0f + psg3.sample / 128.0f + psg4.sample / 128.0f) * 0.25f;
-  if (++frequency_divider == 16) {
-    averaged_sample *= 1.0 / 16.0;
-    frequency_divider = 0;
-    std::lock_guard guard{buffer_mutex};
-    resampler->Write({ averaged_sample, averaged_sample });
-    averaged_sample = 0.0f;
+void APU::Step(int ticks) {
+  auto sample = (psg1.sample / 128.0f + psg2.sample / 128.0f + psg3.sample / 128.0f + psg4.sample / 128.0f) * 0.25f;
+  for (int i = 0; i < ticks; i++) {
+    averaged_sample += sample;
+    if (++frequency_divider == 16) {
+      averaged_sample *= 1.0 / 16.0;
+      frequency_divider = 0;
+      std::lock_guard guard{buffer_mutex};
+      resampler->Write({ averaged_sample, averaged_sample });
+      averaged_sample = 0.0f;
+    }
   }
 }
 
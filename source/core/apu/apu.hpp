@@ -22,7 +22,8 @@ public:
 
   void Reset();
   void SetAudioDevice(AudioDevice* device);
-  void Step();
+  /// Samples the channel outputs for a number of M-cycles during which they do not change.
+  void Step(int ticks);
   auto ReadMMIO(std::uint8_t reg) -> std::uint8_t;
   void WriteMMIO(std::uint8_t reg, std::uint8_t value);
 
@@ -71,6 +72,6 @@ private:
   std::unique_ptr<common::dsp::StereoResampler<float>> resampler;
 
   Scheduler* scheduler;
-  AudioDevice* audio_device;
+  AudioDevice* audio_device = nullptr;
   NullAudioDevice null_audio_device;
 };
@@ -8,6 +8,7 @@
 #include "channel_noise.hpp"
 
 NoiseChannel::NoiseChannel(Scheduler* scheduler) : scheduler(scheduler), sequencer(scheduler) {
+  scheduler->Register<NoiseChannel, &NoiseChannel::Generate>(&event, this);
   sequencer.sweep.enabled = false;
   sequencer.envelope.enabled = true;
   Reset();
@@ -25,13 +26,13 @@ void NoiseChannel::Reset() {
   sample = 0;
   skip_count = 0;
 
-  scheduler->Add(GetSynthesisInterval(7, 15), event_cb);
+  scheduler->Add(&event, GetSynthesisInterval(7, 15));
 }
 
 void NoiseChannel::Generate(int cycles_late) {
   if (length_enable && sequencer.length <= 0) {
     sample = 0;
-    scheduler->Add(GetSynthesisInterval(7, 15) - cycles_late, event_cb);
+    scheduler->Add(&event, GetSynthesisInterval(7, 15) - cycles_late);
     return;
   }
 
@@ -74,7 +75,7 @@ void NoiseChannel::Generate(int cycles_late) {
     skip_count = 0;
   //}
 
-  scheduler->Add(noise_interval - cycles_late, event_cb);
+  scheduler->Add(&event, noise_interval - cycles_late);
 }
 
 auto NoiseChannel::Read(int offset) -> std::uint8_t {
@@ -39,10 +39,8 @@ private:
   std::uint16_t lfsr;
 
   Scheduler* scheduler;
+  Scheduler::Event event;
   Sequencer sequencer;
-  std::function<void(int)> event_cb = [this](int cycles_late) {
-    this->Generate(cycles_late);
-  };
 
   int  frequency_shift;
   int  frequency_ratio;
@@ -8,6 +8,7 @@
 #include "channel_quad.hpp"
 
 QuadChannel::QuadChannel(Scheduler* scheduler) : scheduler(scheduler), sequencer(scheduler) {
+  scheduler->Register<QuadChannel, &QuadChannel::Generate>(&event, this);
   sequencer.sweep.enabled = true;
   sequencer.envelope.enabled = true;
   Reset();
@@ -19,13 +20,13 @@ void QuadChannel::Reset() {
   sample = 0;
   wave_duty = 0;
   length_enable = false;
-  scheduler->Add(GetSynthesisIntervalFromFrequency(0), event_cb);
+  scheduler->Add(&event, GetSynthesisIntervalFromFrequency(0));
 }
 
 void QuadChannel::Generate(int cycles_late) {
   if ((length_enable && sequencer.length <= 0) || sequencer.sweep.channel_disabled) {
     sample = 0;
-    scheduler->Add(GetSynthesisIntervalFromFrequency(0) - cycles_late, event_cb);
+    scheduler->Add(&event, GetSynthesisIntervalFromFrequency(0) - cycles_late);
     return;
   }
 
@@ -39,7 +40,7 @@ void QuadChannel::Generate(int cycles_late) {
   sample = std::int8_t(pattern[wave_duty][phase] * sequencer.envelope.current_volume);
   phase = (phase + 1) % 8;
 
-  scheduler->Add(GetSynthesisIntervalFromFrequency(sequencer.sweep.current_freq) - cycles_late, event_cb);
+  scheduler->Add(&event, GetSynthesisIntervalFromFrequency(sequencer.sweep.current_freq) - cycles_late);
 }
 
 auto QuadChannel::Read(int offset) -> std::uint8_t {
@@ -32,11 +32,9 @@ private:
   }
 
   Scheduler* scheduler;
+  Scheduler::Event event;
   Sequencer sequencer;
   int phase;
   int wave_duty;
   bool length_enable;
-  std::function<void(int)> event_cb = [this](int cycles_late) {
-    this->Generate(cycles_late);
-  };
 };
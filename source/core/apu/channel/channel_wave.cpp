@@ -8,6 +8,7 @@
 #include "channel_wave.hpp"
 
 WaveChannel::WaveChannel(Scheduler* scheduler) : scheduler(scheduler), sequencer(scheduler) {
+  scheduler->Register<WaveChannel, &WaveChannel::Generate>(&event, this);
   sequencer.sweep.enabled = false;
   sequencer.envelope.enabled = false;
   sequencer.length_default = 256;
@@ -34,13 +35,13 @@ void WaveChannel::Reset() {
     }
   }
 
-  scheduler->Add(GetSynthesisIntervalFromFrequency(0), event_cb);
+  scheduler->Add(&event, GetSynthesisIntervalFromFrequency(0));
 }
 
 void WaveChannel::Generate(int cycles_late) {
   if (!enabled || (length_enable && sequencer.length <= 0)) {
     sample = 0;
-    scheduler->Add(GetSynthesisIntervalFromFrequency(0) - cycles_late, event_cb);
+    scheduler->Add(&event, GetSynthesisIntervalFromFrequency(0) - cycles_late);
     return;
   }
 
@@ -61,7 +62,7 @@ void WaveChannel::Generate(int cycles_late) {
     phase = 0;
   }
 
-  scheduler->Add(GetSynthesisIntervalFromFrequency(frequency) - cycles_late, event_cb);
+  scheduler->Add(&event, GetSynthesisIntervalFromFrequency(frequency) - cycles_late);
 }
 
 auto WaveChannel::Read(int offset) -> std::uint8_t {
@@ -37,11 +37,9 @@ private:
     return 2 * (2048 - frequency);
   }
 
-  std::function<void(int)> event_cb = [this](int cycles_late) {
-    this->Generate(cycles_late);
-  };
 
   Scheduler* scheduler;
+  Scheduler::Event event;
   Sequencer sequencer;
 
   bool enabled;
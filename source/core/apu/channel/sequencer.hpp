@@ -142,14 +142,17 @@ private:
 
 class Sequencer {
 public:
-  Sequencer(Scheduler* scheduler) : scheduler(scheduler) { Reset(); }
+  Sequencer(Scheduler* scheduler) : scheduler(scheduler) {
+    scheduler->Register<Sequencer, &Sequencer::Tick>(&event, this);
+    Reset();
+  }
 
   void Reset() {
     length = 0;
     envelope.Reset();
     sweep.Reset();
     step = 0;
-    scheduler->Add(s_cycles_per_step, event_cb);
+    scheduler->Add(&event, s_cycles_per_step);
   }
 
   void Restart() {
@@ -174,13 +177,9 @@ public:
       case 7: envelope.Tick(); break;
     }
     step = (step + 1) % 8;
-    scheduler->Add(s_cycles_per_step - cycles_late, event_cb);
+    scheduler->Add(&event, s_cycles_per_step - cycles_late);
   }
 
-  std::function<void(int)> event_cb = [this](int cycles_late) {
-    this->Tick(cycles_late);
-  };
-
   int length;
   int length_default = 64;
   Envelope envelope;
@@ -189,6 +188,7 @@ public:
 private:
   int step;
   Scheduler* scheduler;
+  Scheduler::Event event;
 
   static constexpr int s_cycles_per_step = 4194304/512;
 };
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Interface between the CPU and code generated by the ahead-of-time
+/// recompiler (source/tools/aot). Generated code only includes this header.
+
+/// Incremented whenever the layout of the types below changes.
+constexpr std::uint32_t kAOTVersion = 2;
+
+/// Guest state passed to generated code.
+/// The registers are copied in and out by the CPU around each block, and
+/// around the rare instructions that generated code leaves to `execute`.
+struct AOTState {
+  std::uint8_t a, f, b, c, d, e, h, l;
+  std::uint16_t sp;
+  std::uint16_t pc;
+
+  bool const* interrupt_master_enable;
+  bool const* interrupt_requested;
+  std::uint32_t const* code_generation;
+
+  void* cpu;
+
+  /// Set by the callbacks below once the time reached `deadline`.
+  std::uint64_t deadline;
+  bool deadline_reached;
+
+  /// Advances time by `count` memory accesses.
+  void (*tick)(AOTState* state, int count);
+
+  /// Memory accesses, including the time they take.
+  std::uint8_t (*read)(AOTState* state, std::uint16_t address);
+  void (*write)(AOTState* state, std::uint16_t address, std::uint8_t value);
+
+  /// Runs a single instruction in the interpreter, starting with its opcode fetch.
+  void (*execute)(AOTState* state, std::uint8_t opcode, std::uint8_t imm0, std::uint8_t imm1);
+};
+
+/// Returns true if the block ran up to and including its last instruction.
+using AOTFunction = bool (*)(AOTState* state);
+
+struct AOTBlock {
+  std::uint16_t bank;
+  std::uint16_t address;
+  AOTFunction function;
+};
+
+/// Exported by generated modules under the name in kAOTModuleSymbol.
+struct AOTModuleInfo {
+  std::uint32_t version;
+  std::uint32_t rom_hash;
+  std::uint32_t block_count;
+  AOTBlock const* blocks;
+};
+
+constexpr char kAOTModuleSymbol[] = "reboy_aot_module";
+
+#ifdef _WIN32
+  #define AOT_EXPORT extern "C" __declspec(dllexport)
+#else
+  #define AOT_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+/// FNV-1a hash identifying the ROM a module was generated from.
+inline auto AOTHashROM(std::uint8_t const* data, std::size_t size) -> std::uint32_t {
+  std::uint32_t hash = 0x811C9DC5;
+  for (std::size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 0x01000193;
+  }
+  return hash;
+}
+
+/// ALU helpers for generated code, matching the interpreter's flag behavior.
+
+inline void AOTAdd(AOTState* s, std::uint8_t value, int carry) {
+  unsigned result = s->a + value + carry;
+  s->f = ((result & 0xFF) == 0 ? 0x80 : 0) |
+         (((s->a & 0xF) + (value & 0xF) + carry) & 0x10 ? 0x20 : 0) |
+         (result & 0x100 ? 0x10 : 0);
+  s->a = std::uint8_t(result);
+}
+
+inline void AOTSub(AOTState* s, std::uint8_t value, int carry, bool store) {
+  std::uint8_t result = s->a - value - carry;
+  s->f = (result == 0 ? 0x80 : 0) | 0x40 |
+         ((s->a & 0xF) < ((value & 0xF) + carry) ? 0x20 : 0) |
+         (s->a < (value + carry) ? 0x10 : 0);
+  if (store)
+    s->a = result;
+}
+
+inline void AOTAnd(AOTState* s, std::uint8_t value) {
+  s->a &= value;
+  s->f = (s->a == 0 ? 0x80 : 0) | 0x20;
+}
+
+inline void AOTXor(AOTState* s, std::uint8_t value) {
+  s->a ^= value;
+  s->f = s->a == 0 ? 0x80 : 0;
+}
+
+inline void AOTOr(AOTState* s, std::uint8_t value) {
+  s->a |= value;
+  s->f = s->a == 0 ? 0x80 : 0;
+}
+
+inline void AOTInc(AOTState* s, std::uint8_t& reg) {
+  s->f = (s->f & 0x10) | ((reg & 0xF) == 0xF ? 0x20 : 0);
+  if (++reg == 0)
+    s->f |= 0x80;
+}
+
+inline void AOTDec(AOTState* s, std::uint8_t& reg) {
+  s->f = (s->f & 0x10) | 0x40 | ((reg & 0xF) == 0 ? 0x20 : 0);
+  if (--reg == 0)
+    s->f |= 0x80;
+}
+
+inline void AOTAddPair(std::uint8_t& hi, std::uint8_t& lo, int value) {
+  std::uint16_t result = ((hi << 8) | lo) + value;
+  hi = result >> 8;
+  lo = result & 0xFF;
+}
+
+inline void AOTAddHL(AOTState* s, std::uint16_t value) {
+  std::uint16_t hl = (s->h << 8) | s->l;
+  std::uint16_t result = hl + value;
+  s->f = (s->f & 0x80) |
+         (((hl & 0xFFF) + (value & 0xFFF)) & 0x1000 ? 0x20 : 0) |
+         (result < hl ? 0x10 : 0);
+  s->h = result >> 8;
+  s->l = result & 0xFF;
+}
+
+/// INC (HL) and DEC (HL). Like the interpreter, reads the operand a second
+/// time for the half-carry flag.
+inline void AOTIncDecHL(AOTState* s, int delta) {
+  std::uint16_t address = (s->h << 8) | s->l;
+  std::uint8_t result = s->read(s, address) + delta;
+  std::uint8_t value = s->read(s, address);
+  s->f = (s->f & 0x10) | (result == 0 ? 0x80 : 0);
+  if (delta > 0) {
+    s->f |= (value & 0xF) == 0xF ? 0x20 : 0;
+  } else {
+    s->f |= 0x40 | ((value & 0xF) == 0 ? 0x20 : 0);
+  }
+  s->write(s, address, result);
+}
+
+/// RLC, RRC, RL, RR, SLA, SRA, SWAP and SRL, in the order of the CB opcodes.
+inline auto AOTShift(AOTState* s, int op, std::uint8_t value) -> std::uint8_t {
+  int carry_in = (s->f >> 4) & 1;
+  int carry = 0;
+  switch (op) {
+    case 0: carry = value >> 7; value = (value << 1) | carry; break;
+    case 1: carry = value & 1; value = (value >> 1) | (carry << 7); break;
+    case 2: carry = value >> 7; value = (value << 1) | carry_in; break;
+    case 3: carry = value & 1; value = (value >> 1) | (carry_in << 7); break;
+    case 4: carry = value >> 7; value <<= 1; break;
+    case 5: carry = value & 1; value = (value & 0x80) | (value >> 1); break;
+    case 6: value = (value << 4) | (value >> 4); break;
+    case 7: carry = value & 1; value >>= 1; break;
+  }
+  s->f = (value == 0 ? 0x80 : 0) | (carry ? 0x10 : 0);
+  return value;
+}
+
+inline void AOTBit(AOTState* s, int bit, std::uint8_t value) {
+  s->f = (s->f & 0x10) | 0x20 | ((value & (1 << bit)) == 0 ? 0x80 : 0);
+}
+
+inline void AOTPush(AOTState* s, std::uint16_t value) {
+  s->sp -= 2;
+  s->write(s, s->sp, value & 0xFF);
+  s->write(s, std::uint16_t(s->sp + 1), value >> 8);
+}
+
+inline auto AOTPop(AOTState* s) -> std::uint16_t {
+  std::uint8_t lo = s->read(s, s->sp);
+  std::uint8_t hi = s->read(s, std::uint16_t(s->sp + 1));
+  s->sp += 2;
+  return lo | (hi << 8);
+}
+
+/// Checks if the CPU must return to the dispatcher to service an interrupt
+/// or because the deadline was reached.
+inline auto AOTShouldReturn(AOTState* s) -> bool {
+  return s->deadline_reached || (*s->interrupt_master_enable && *s->interrupt_requested);
+}
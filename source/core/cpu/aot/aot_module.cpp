@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <cstdio>
+
+#include "aot_module.hpp"
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <dlfcn.h>
+#endif
+
+AOTModule::~AOTModule() {
+  if (handle == nullptr)
+    return;
+#ifdef _WIN32
+  FreeLibrary(static_cast<HMODULE>(handle));
+#else
+  dlclose(handle);
+#endif
+}
+
+auto AOTModule::Load(std::string const& path) -> bool {
+  AOTModuleInfo const* info = nullptr;
+
+#ifdef _WIN32
+  auto library = LoadLibraryA(path.c_str());
+  if (library != nullptr) {
+    handle = library;
+    info = reinterpret_cast<AOTModuleInfo const*>(GetProcAddress(library, kAOTModuleSymbol));
+  }
+#else
+  // Always treat the path as a file, dlopen() would search the library path otherwise.
+  auto file = path.find('/') == std::string::npos ? "./" + path : path;
+  handle = dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle != nullptr)
+    info = static_cast<AOTModuleInfo const*>(dlsym(handle, kAOTModuleSymbol));
+#endif
+
+  if (handle == nullptr) {
+    std::printf("Failed to load AOT module: %s\n", path.c_str());
+    return false;
+  }
+
+  if (info == nullptr || info->version != kAOTVersion) {
+    std::printf("Bad or outdated AOT module: %s\n", path.c_str());
+    return false;
+  }
+
+  rom_hash = info->rom_hash;
+  for (std::uint32_t i = 0; i < info->block_count; i++) {
+    auto& block = info->blocks[i];
+    functions[(block.bank << 16) | block.address] = block.function;
+  }
+  return true;
+}
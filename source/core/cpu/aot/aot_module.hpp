@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "aot.hpp"
+
+/// Shared object produced by compiling the output of the ahead-of-time recompiler.
+class AOTModule {
+public:
+  AOTModule() = default;
+  AOTModule(AOTModule const&) = delete;
+ ~AOTModule();
+
+  auto Load(std::string const& path) -> bool;
+  auto GetROMHash() const -> std::uint32_t { return rom_hash; }
+
+  /// Returns the compiled block starting at an address, or nullptr if there is none.
+  auto Find(int bank, std::uint16_t address) const -> AOTFunction {
+    auto match = functions.find((bank << 16) | address);
+    if (match == functions.end())
+      return nullptr;
+    return match->second;
+  }
+
+private:
+  void* handle = nullptr;
+  std::uint32_t rom_hash = 0;
+  std::unordered_map<std::uint32_t, AOTFunction> functions;
+};
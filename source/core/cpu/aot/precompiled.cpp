@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "../cpu.hpp"
+#include "../../memory.hpp"
+
+template <typename Bus>
+auto CPU<Bus>::StepPrecompiled(std::uint64_t deadline) -> bool {
+  // Keep interpreting a block that has no compiled code.
+  if (current_op != current_op_end &&
+      current_op->address == pc &&
+      current_code_generation == memory->code_generation) {
+    return StepCached();
+  }
+
+  auto block = GetBlock(pc);
+  if (block == nullptr) {
+    current_op = nullptr;
+    current_op_end = nullptr;
+    return false;
+  }
+
+  current_code_generation = memory->code_generation;
+
+  if (block->precompiled != nullptr) {
+    current_op = nullptr;
+    current_op_end = nullptr;
+
+    MaterializeFlags();
+
+    AOTState state;
+    state.a = af.byte.hi;
+    state.f = af.byte.lo;
+    state.b = bc.byte.hi;
+    state.c = bc.byte.lo;
+    state.d = de.byte.hi;
+    state.e = de.byte.lo;
+    state.h = hl.byte.hi;
+    state.l = hl.byte.lo;
+    state.sp = sp;
+    state.pc = pc;
+    state.interrupt_master_enable = &interrupt_master_enable;
+    state.interrupt_requested = &interrupt_requested;
+    state.code_generation = &memory->code_generation;
+    state.cpu = this;
+    state.deadline = deadline;
+    state.deadline_reached = false;
+    state.tick = &AOTTick;
+    state.read = &AOTRead;
+    state.write = &AOTWrite;
+    state.execute = &AOTExecute;
+
+    bool completed = block->precompiled(&state);
+
+    af.byte.hi = state.a;
+    af.byte.lo = state.f;
+    bc.byte.hi = state.b;
+    bc.byte.lo = state.c;
+    de.byte.hi = state.d;
+    de.byte.lo = state.e;
+    hl.byte.hi = state.h;
+    hl.byte.lo = state.l;
+    sp = state.sp;
+    pc = state.pc;
+
+    if (completed)
+      DetectIdleLoop(block);
+    return true;
+  }
+
+  current_op = block->ops.data();
+  current_op_end = current_op + block->ops.size();
+  return StepCached();
+}
+
+template <typename Bus>
+void CPU<Bus>::RunPrecompiled(std::uint64_t deadline) {
+  do {
+    // The HALT bug fetches the same opcode twice, leave it to the interpreter.
+    if (halt_bug || !StepPrecompiled(deadline))
+      StepInterpreter();
+  } while (!ShouldStop(deadline));
+}
+
+template <typename Bus>
+void CPU<Bus>::AOTTick(AOTState* state, int count) {
+  auto cpu = static_cast<CPU*>(state->cpu);
+  for (int i = 0; i < count; i++)
+    cpu->memory->Tick();
+  state->deadline_reached = cpu->memory->GetTimestampNow() >= state->deadline;
+}
+
+template <typename Bus>
+auto CPU<Bus>::AOTRead(AOTState* state, std::uint16_t address) -> std::uint8_t {
+  auto cpu = static_cast<CPU*>(state->cpu);
+  auto value = cpu->memory->ReadByte(address);
+  state->deadline_reached = cpu->memory->GetTimestampNow() >= state->deadline;
+  return value;
+}
+
+template <typename Bus>
+void CPU<Bus>::AOTWrite(AOTState* state, std::uint16_t address, std::uint8_t value) {
+  auto cpu = static_cast<CPU*>(state->cpu);
+  cpu->memory->WriteByte(address, value);
+  state->deadline_reached = cpu->memory->GetTimestampNow() >= state->deadline;
+}
+
+template <typename Bus>
+void CPU<Bus>::AOTExecute(AOTState* state, std::uint8_t opcode, std::uint8_t imm0, std::uint8_t imm1) {
+  auto cpu = static_cast<CPU*>(state->cpu);
+
+  cpu->af.byte.hi = state->a;
+  cpu->af.byte.lo = state->f;
+  cpu->bc.byte.hi = state->b;
+  cpu->bc.byte.lo = state->c;
+  cpu->de.byte.hi = state->d;
+  cpu->de.byte.lo = state->e;
+  cpu->hl.byte.hi = state->h;
+  cpu->hl.byte.lo = state->l;
+  cpu->sp = state->sp;
+  cpu->pc = state->pc;
+
+  DecodedOp op;
+  op.address = state->pc;
+  op.opcode = opcode;
+  op.prefix_cb = opcode == 0xCB;
+  op.handler = op.prefix_cb ? sOpcodeTableCB[imm0] : sOpcodeTable[opcode];
+  op.imm[0] = imm0;
+  op.imm[1] = imm1;
+  cpu->ExecuteDecoded(&op);
+  cpu->MaterializeFlags();
+  state->deadline_reached = cpu->ShouldStop(state->deadline);
+
+  state->a = cpu->af.byte.hi;
+  state->f = cpu->af.byte.lo;
+  state->b = cpu->bc.byte.hi;
+  state->c = cpu->bc.byte.lo;
+  state->d = cpu->de.byte.hi;
+  state->e = cpu->de.byte.lo;
+  state->h = cpu->hl.byte.hi;
+  state->l = cpu->hl.byte.lo;
+  state->sp = cpu->sp;
+  state->pc = cpu->pc;
+}
+
+template auto CPU<Memory>::StepPrecompiled(std::uint64_t deadline) -> bool;
+template void CPU<Memory>::RunPrecompiled(std::uint64_t deadline);
+template void CPU<Memory>::AOTTick(AOTState* state, int count);
+template auto CPU<Memory>::AOTRead(AOTState* state, std::uint16_t address) -> std::uint8_t;
+template void CPU<Memory>::AOTWrite(AOTState* state, std::uint16_t address, std::uint8_t value);
+template void CPU<Memory>::AOTExecute(AOTState* state, std::uint8_t opcode, std::uint8_t imm0, std::uint8_t imm1);
+
+template auto CPU<MemoryBase>::StepPrecompiled(std::uint64_t deadline) -> bool;
+template void CPU<MemoryBase>::RunPrecompiled(std::uint64_t deadline);
+template void CPU<MemoryBase>::AOTTick(AOTState* state, int count);
+template auto CPU<MemoryBase>::AOTRead(AOTState* state, std::uint16_t address) -> std::uint8_t;
+template void CPU<MemoryBase>::AOTWrite(AOTState* state, std::uint16_t address, std::uint8_t value);
+template void CPU<MemoryBase>::AOTExecute(AOTState* state, std::uint8_t opcode, std::uint8_t imm0, std::uint8_t imm1);
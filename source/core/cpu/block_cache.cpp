@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "cpu.hpp"
+#include "../memory.hpp"
+#include "opcode_info.hpp"
+
+template <typename Bus>
+auto CPU<Bus>::StepCached() -> bool {
+  if (current_op == current_op_end ||
+      current_op->address != pc ||
+      current_code_generation != memory->code_generation) {
+    auto block = GetBlock(pc);
+    if (block == nullptr) {
+      current_op = nullptr;
+      current_op_end = nullptr;
+      return false;
+    }
+    current_op = block->ops.data();
+    current_op_end = current_op + block->ops.size();
+    current_code_generation = memory->code_generation;
+  }
+
+  ExecuteDecoded(current_op++);
+  return true;
+}
+
+template <typename Bus>
+void CPU<Bus>::ExecuteDecoded(DecodedOp const* op) {
+  // Opcode fetch. The immediate operands are fetched by the handler.
+  memory->Tick();
+  pc++;
+  if (op->prefix_cb) {
+    memory->Tick();
+    pc++;
+  }
+
+  prefetch = op->imm;
+  (this->*op->handler)();
+  prefetch = nullptr;
+}
+
+template <typename Bus>
+auto CPU<Bus>::GetBlock(std::uint16_t address) -> Block* {
+  auto bank = memory->GetCodeBank(address);
+  if (bank < 0)
+    return nullptr;
+
+  auto& blocks = block_cache[bank];
+  if (blocks.empty())
+    blocks.resize(0x4000);
+
+  auto& block = blocks[address & 0x3FFF];
+  if (!block) {
+    block = DecodeBlock(address, bank);
+    if (block && aot_module != nullptr)
+      block->precompiled = aot_module->Find(bank, address);
+  }
+  return block.get();
+}
+
+template <typename Bus>
+auto CPU<Bus>::DecodeBlock(std::uint16_t address, int bank) -> std::unique_ptr<Block> {
+  auto block = std::make_unique<Block>();
+
+  while (block->ops.size() < kMaxBlockLength) {
+    auto opcode = memory->ReadCode(address);
+    auto length = kOpcodeLength[opcode];
+
+    // Do not decode instructions that cross into a different bank.
+    if (memory->GetCodeBank(address + length - 1) != bank)
+      break;
+
+    DecodedOp op;
+    op.address = address;
+    op.opcode = opcode;
+    op.length = length;
+    op.prefix_cb = opcode == 0xCB;
+    if (op.prefix_cb) {
+      op.imm[0] = memory->ReadCode(address + 1);
+      op.handler = sOpcodeTableCB[op.imm[0]];
+    } else {
+      op.handler = sOpcodeTable[opcode];
+      if (length >= 2)
+        op.imm[0] = memory->ReadCode(address + 1);
+      if (length == 3)
+        op.imm[1] = memory->ReadCode(address + 2);
+    }
+    block->ops.push_back(op);
+
+    address += length;
+    if (EndsBlock(opcode))
+      break;
+  }
+
+  if (block->ops.empty())
+    return nullptr;
+  return block;
+}
+
+template <typename Bus>
+void CPU<Bus>::FlushBlockCache() {
+  for (auto& blocks : block_cache)
+    blocks.clear();
+  code_buffer.Reset();
+  current_op = nullptr;
+  current_op_end = nullptr;
+}
+
+template auto CPU<Memory>::StepCached() -> bool;
+template void CPU<Memory>::ExecuteDecoded(DecodedOp const* op);
+template auto CPU<Memory>::GetBlock(std::uint16_t address) -> Block*;
+template auto CPU<Memory>::DecodeBlock(std::uint16_t address, int bank) -> std::unique_ptr<Block>;
+template void CPU<Memory>::FlushBlockCache();
+
+template auto CPU<MemoryBase>::StepCached() -> bool;
+template void CPU<MemoryBase>::ExecuteDecoded(DecodedOp const* op);
+template auto CPU<MemoryBase>::GetBlock(std::uint16_t address) -> Block*;
+template auto CPU<MemoryBase>::DecodeBlock(std::uint16_t address, int bank) -> std::unique_ptr<Block>;
+template void CPU<MemoryBase>::FlushBlockCache();
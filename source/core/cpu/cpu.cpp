@@ -5,13 +5,19 @@
  * Refer to the included LICENSE file.
  */
 
+#include <limits>
+
 #include "cpu.hpp"
+#include "../memory.hpp"
 
-CPU::CPU(MemoryBase* memory) : memory(memory) {
+template <typename Bus>
+CPU<Bus>::CPU(Bus* memory) : memory(memory) {
   Reset();
 }
 
-void CPU::Reset() {
+template <typename Bus>
+void CPU<Bus>::Reset() {
+  lazy_flags = {};
   GetRegW(RegW::AF) = 0;
   GetRegW(RegW::BC) = 0;
   GetRegW(RegW::DE) = 0;
@@ -21,9 +27,28 @@ void CPU::Reset() {
   interrupt_master_enable = false;
   halted = false;
   halt_bug = false;
+  interrupt_requested = false;
+  idle_loop = {};
+  FlushBlockCache();
+}
+
+template <typename Bus>
+void CPU<Bus>::SetBackend(Backend backend) {
+  this->backend = backend;
+  if (backend == Backend::Recompiler)
+    code_buffer.Map();
+  current_op = nullptr;
+  current_op_end = nullptr;
+}
+
+template <typename Bus>
+void CPU<Bus>::SetAOTModule(AOTModule const* module) {
+  aot_module = module;
+  FlushBlockCache();
 }
 
-void CPU::RaiseIRQ(std::uint8_t vector) {
+template <typename Bus>
+void CPU<Bus>::RaiseIRQ(std::uint8_t vector) {
   halted = false;
   //halt_bug = false;
   if (interrupt_master_enable) {
@@ -33,11 +58,13 @@ void CPU::RaiseIRQ(std::uint8_t vector) {
   }
 }
 
-auto CPU::GetRegB(RegB reg) -> std::uint8_t& {
+template <typename Bus>
+auto CPU<Bus>::GetRegB(RegB reg) -> std::uint8_t& {
   switch (reg) {
     case RegB::A:
       return af.byte.hi;
     case RegB::F:
+      MaterializeFlags();
       return af.byte.lo;
     case RegB::B:
       return bc.byte.hi;
@@ -54,9 +81,11 @@ auto CPU::GetRegB(RegB reg) -> std::uint8_t& {
   }
 }
 
-auto CPU::GetRegW(RegW reg) -> std::uint16_t& {
+template <typename Bus>
+auto CPU<Bus>::GetRegW(RegW reg) -> std::uint16_t& {
   switch (reg) {
     case RegW::AF:
+      MaterializeFlags();
       return af.word;
     case RegW::BC:
       return bc.word;
@@ -71,20 +100,66 @@ auto CPU::GetRegW(RegW reg) -> std::uint16_t& {
   }
 }
 
-void CPU::SetFlag(Flag flag, bool is_set) {
-  auto& f = GetRegB(RegB::F);
-  if (is_set) {
-    f |= static_cast<std::uint8_t>(flag);
-  } else {
-    f &= ~static_cast<std::uint8_t>(flag);
+template <typename Bus>
+void CPU<Bus>::ComputeLazyFlags() {
+  auto& flags = lazy_flags;
+  std::uint8_t f = flags.result == 0 ? static_cast<std::uint8_t>(Flag::Zero) : 0;
+
+  switch (flags.op) {
+    case FlagOp::Add:
+      if (((flags.lhs & 0xF) + (flags.rhs & 0xF) + flags.carry) & 0x10)
+        f |= static_cast<std::uint8_t>(Flag::HalfCarry);
+      if ((flags.lhs + flags.rhs + flags.carry) & 0x100)
+        f |= static_cast<std::uint8_t>(Flag::Carry);
+      break;
+    case FlagOp::Sub:
+      f |= static_cast<std::uint8_t>(Flag::Negative);
+      if ((flags.lhs & 0xF) < ((flags.rhs & 0xF) + flags.carry))
+        f |= static_cast<std::uint8_t>(Flag::HalfCarry);
+      if (flags.lhs < (flags.rhs + flags.carry))
+        f |= static_cast<std::uint8_t>(Flag::Carry);
+      break;
+    case FlagOp::And:
+      f |= static_cast<std::uint8_t>(Flag::HalfCarry);
+      break;
+    case FlagOp::Shift:
+      if (flags.carry)
+        f |= static_cast<std::uint8_t>(Flag::Carry);
+      break;
+    default:
+      break;
   }
+
+  af.byte.lo = f;
+  flags.op = FlagOp::None;
 }
 
-auto CPU::GetFlag(Flag flag) -> bool {
-  return GetRegB(RegB::F) & static_cast<std::uint8_t>(flag);
+template <typename Bus>
+void CPU<Bus>::Step(std::uint64_t deadline) {
+  if (!halt_bug) {
+    switch (backend) {
+      case Backend::CachedInterpreter:
+        if (StepCached())
+          return;
+        break;
+      case Backend::Recompiler:
+        if (StepRecompiled(deadline))
+          return;
+        break;
+      case Backend::Precompiled:
+        if (StepPrecompiled(deadline))
+          return;
+        break;
+      default:
+        break;
+    }
+  }
+
+  StepInterpreter();
 }
 
-void CPU::Step() {
+template <typename Bus>
+void CPU<Bus>::StepInterpreter() {
   auto opcode = memory->ReadByte(GetRegW(RegW::PC)++);
   if (halt_bug) {
     GetRegW(RegW::PC)--;
@@ -92,3 +167,19 @@ void CPU::Step() {
   }
   (this->*sOpcodeTable[opcode])();
 }
+
+template <typename Bus>
+void CPU<Bus>::Run(std::uint64_t deadline) {
+  if (backend == Backend::ThreadedInterpreter) {
+    RunThreaded(deadline);
+  } else if (backend == Backend::Recompiler) {
+    RunRecompiled(deadline);
+  } else if (backend == Backend::Precompiled) {
+    RunPrecompiled(deadline);
+  } else {
+    Step();
+  }
+}
+
+template class CPU<Memory>;
+template class CPU<MemoryBase>;
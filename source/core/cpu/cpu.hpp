@@ -8,22 +8,71 @@
 #pragma once
 
 #include <cstdio>
+#include <limits>
+#include <memory>
+#include <vector>
 
+#include "aot/aot_module.hpp"
 #include "memory.hpp"
+#include "recompiler/code_buffer.hpp"
 
+enum class CPUBackend {
+  /// Fetches and decodes every instruction through the opcode tables.
+  Interpreter,
+  /// Interpreter with computed-goto dispatch, runs up to the deadline.
+  ThreadedInterpreter,
+  /// Runs pre-decoded blocks from the block cache. It is not faster than the
+  /// interpreter on its own (about 3% slower in headless runs), but it is the
+  /// front end of the recompiler and the precompiled backend, which decode
+  /// blocks through it and fall back to it for blocks without native code.
+  CachedInterpreter,
+  /// Compiles hot blocks to x86-64 code at runtime.
+  Recompiler,
+  /// Runs blocks from a module built by the ahead-of-time recompiler.
+  Precompiled
+};
+
+/// The CPU is parameterized on the concrete bus type so that memory accesses
+/// can be inlined. MemoryBase can be used as the bus to plug in any memory.
+template <typename Bus>
 class CPU {
 public:
-  CPU(MemoryBase* memory);
+  using Backend = CPUBackend;
+
+  CPU(Bus* memory);
 
   void Reset();
-  void Step();
+
+  /// Runs one instruction, or one block with the recompiling backends.
+  /// Blocks stop early once `deadline` is reached.
+  void Step(std::uint64_t deadline = std::numeric_limits<std::uint64_t>::max());
+
+  /// Runs instructions until `deadline`, or until something other than the
+  /// CPU has to run. The interpreter and the cached interpreter run one step.
+  void Run(std::uint64_t deadline);
+
   void RaiseIRQ(std::uint8_t vector);
+  void SetBackend(Backend backend);
+  void SetAOTModule(AOTModule const* module);
   auto IsHalted() -> bool { return halted; }
+  auto GetPC() const -> std::uint16_t { return pc; }
+
+  /// True right after the CPU closed an iteration of a loop that can only
+  /// exit once a scheduled event changed something it polls.
+  auto IsIdleLooping() -> bool {
+    return idle_loop.confirmed && idle_loop.timestamp == memory->GetTimestampNow();
+  }
+
+  /// Cycles taken by a single iteration of the current idle loop.
+  auto GetIdleLoopCycles() -> int { return idle_loop.cycles; }
 
   bool interrupt_master_enable;
 
+  /// Set by the interrupt controller while an enabled interrupt is requested.
+  bool interrupt_requested = false;
+
 private:
-  MemoryBase* memory;
+  Bus* memory;
 
   enum class RegB {
     A, F, B, C, D, E, H, L
@@ -40,10 +89,57 @@ private:
     Zero = 0x80
   };
 
+  /// Operation that last wrote all four flags. F is only brought up to date
+  /// when something reads it, since most flag results are overwritten first.
+  enum class FlagOp : std::uint8_t {
+    None, // F is up to date
+    Add,
+    Sub,
+    And,
+    Or,
+    Shift
+  };
+
+  struct LazyFlags {
+    FlagOp op = FlagOp::None;
+    std::uint8_t result;
+    std::uint8_t lhs;
+    std::uint8_t rhs;
+    std::uint8_t carry;
+  } lazy_flags;
+
   auto GetRegB(RegB reg) -> std::uint8_t&;
   auto GetRegW(RegW reg) -> std::uint16_t&;
-  void SetFlag(Flag flag, bool is_set);
-  auto GetFlag(Flag flag) -> bool;
+
+  void SetFlag(Flag flag, bool is_set) {
+    MaterializeFlags();
+    if (is_set) {
+      af.byte.lo |= static_cast<std::uint8_t>(flag);
+    } else {
+      af.byte.lo &= ~static_cast<std::uint8_t>(flag);
+    }
+  }
+
+  auto GetFlag(Flag flag) -> bool {
+    MaterializeFlags();
+    return af.byte.lo & static_cast<std::uint8_t>(flag);
+  }
+
+  /// Defers computing the flags for an operation that writes all of them.
+  void SetFlagsLazy(FlagOp op, std::uint8_t result, std::uint8_t lhs = 0, std::uint8_t rhs = 0, std::uint8_t carry = 0) {
+    lazy_flags.op = op;
+    lazy_flags.result = result;
+    lazy_flags.lhs = lhs;
+    lazy_flags.rhs = rhs;
+    lazy_flags.carry = carry;
+  }
+
+  void MaterializeFlags() {
+    if (lazy_flags.op != FlagOp::None)
+      ComputeLazyFlags();
+  }
+
+  void ComputeLazyFlags();
 
   // TODO: add support for big-endian systems.
   union GPR {
@@ -59,19 +155,143 @@ private:
   bool halted = false;
   bool halt_bug;
 
+  auto ReadWord(std::uint16_t address) -> std::uint16_t {
+    auto lo = memory->ReadByte(address);
+    auto hi = memory->ReadByte(address + 1);
+    return lo | (hi << 8);
+  }
+
+  void WriteWord(std::uint16_t address, std::uint16_t value) {
+    memory->WriteByte(address, value & 0xFF);
+    memory->WriteByte(address + 1, value >> 8);
+  }
+
   void Push(std::uint16_t value) {
     sp -= 2;
-    memory->WriteWord(sp, value);
+    WriteWord(sp, value);
   }
 
   auto Pop() -> std::uint16_t {
-    auto value = memory->ReadWord(sp);
+    auto value = ReadWord(sp);
     sp += 2;
     return value;
   }
 
+  auto FetchByte() -> std::uint8_t {
+    if (prefetch != nullptr) {
+      memory->Tick();
+      pc++;
+      return *prefetch++;
+    }
+    return memory->ReadByte(pc++);
+  }
+
+  auto FetchWord() -> std::uint16_t {
+    auto lo = FetchByte();
+    auto hi = FetchByte();
+    return lo | (hi << 8);
+  }
+
+  /// Pre-decoded instruction with its immediate operands.
+  struct DecodedOp {
+    void (CPU::*handler)(void);
+    std::uint16_t address;
+    std::uint8_t opcode;
+    std::uint8_t length;
+    bool prefix_cb;
+    std::uint8_t imm[2];
+  };
+
+  /// Straight-line run of pre-decoded instructions from ROM.
+  struct Block {
+    std::vector<DecodedOp> ops;
+    int hits = 0;
+    /// Compiled code. Runs the instructions that end within `limit` cycles,
+    /// as returned by GetCycleLimit().
+    int (*code)(CPU* cpu, std::uint64_t deadline, int limit) = nullptr;
+    /// Cycles taken by the first instruction, at most.
+    int min_cycles = 0;
+    AOTFunction precompiled = nullptr;
+  };
+
+  /// Last backward branch target, checked for being an idle loop.
+  struct IdleLoop {
+    std::uint16_t address = 0;
+    std::uint16_t end = 0;
+    std::uint32_t code_generation = 0;
+    std::uint16_t bc = 0;
+    std::uint16_t hl = 0;
+    int cycles = 0;
+    bool confirmed = false;
+    std::uint16_t af = 0;
+    std::uint64_t timestamp = 0;
+    std::uint64_t next_event = 0;
+  } idle_loop;
+
+  void DetectIdleLoop(std::uint16_t end);
+  /// Runs idle loop detection for a block that was executed up to its end
+  /// by a backend that does not execute JR and JP through the interpreter.
+  void DetectIdleLoop(Block const* block);
+  auto AnalyzeIdleLoop(std::uint16_t address, std::uint16_t end) -> int;
+  auto IsIdlePollAddress(std::uint16_t address) -> bool;
+
+  Backend backend = Backend::Interpreter;
+
+  /// Immediate operands of the instruction being executed from the block cache.
+  std::uint8_t const* prefetch = nullptr;
+
+  DecodedOp const* current_op = nullptr;
+  DecodedOp const* current_op_end = nullptr;
+  std::uint32_t current_code_generation;
+
+  /// Decoded blocks for each ROM bank, indexed by the address inside the bank.
+  std::vector<std::unique_ptr<Block>> block_cache[256];
+
+  /// Ahead-of-time compiled code, only used by the precompiled backend.
+  AOTModule const* aot_module = nullptr;
+
+  static constexpr std::size_t kCodeBufferSize = 16 * 1024 * 1024;
+
+  /// Native code for hot blocks, only used by the recompiler backend.
+  CodeBuffer code_buffer{kCodeBufferSize};
+
+  /// True once anything outside of the CPU needs to run: the deadline is reached,
+  /// the CPU halted, an interrupt is about to be serviced or an idle loop can be skipped.
+  auto ShouldStop(std::uint64_t deadline) -> bool {
+    return memory->GetTimestampNow() >= deadline ||
+           halted ||
+           (interrupt_master_enable && interrupt_requested) ||
+           IsIdleLooping();
+  }
+
+  struct Compiler;
+
+  void StepInterpreter();
+  void RunThreaded(std::uint64_t deadline);
+  void RunRecompiled(std::uint64_t deadline);
+  void RunPrecompiled(std::uint64_t deadline);
+  auto StepCached() -> bool;
+  auto StepRecompiled(std::uint64_t deadline) -> bool;
+  auto StepPrecompiled(std::uint64_t deadline) -> bool;
+  void ExecuteDecoded(DecodedOp const* op);
+  void CompileBlock(Block* block);
+
+  /// Cycles that can run before the next event is due or the deadline is
+  /// reached, -1 if the deadline was reached already.
+  auto GetCycleLimit(std::uint64_t deadline) -> int;
+
+  auto GetBlock(std::uint16_t address) -> Block*;
+  auto DecodeBlock(std::uint16_t address, int bank) -> std::unique_ptr<Block>;
+  void FlushBlockCache();
+
   #include "instructions.inc"
 
   static void (CPU::*sOpcodeTable[256])(void);
   static void (CPU::*sOpcodeTableCB[256])(void);
+
+  static void ExecuteDecodedThunk(CPU* cpu, DecodedOp const* op);
+  static void AOTTick(AOTState* state, int count);
+  static auto AOTRead(AOTState* state, std::uint16_t address) -> std::uint8_t;
+  static void AOTWrite(AOTState* state, std::uint16_t address, std::uint8_t value);
+  static void AOTExecute(AOTState* state, std::uint8_t opcode, std::uint8_t imm0, std::uint8_t imm1);
 };
\ No newline at end of file
@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "cpu.hpp"
+#include "../memory.hpp"
+#include "opcode_info.hpp"
+
+/// Maximum size in bytes of a loop body considered for idle loop detection.
+static constexpr int kMaxIdleLoopLength = 16;
+
+template <typename Bus>
+void CPU<Bus>::DetectIdleLoop(std::uint16_t end) {
+  auto& loop = idle_loop;
+
+  // The analysis depends on BC and HL for indirect loads.
+  if (loop.address != pc || loop.end != end || loop.code_generation != memory->code_generation ||
+      loop.bc != bc.word || loop.hl != hl.word) {
+    loop.address = pc;
+    loop.end = end;
+    loop.code_generation = memory->code_generation;
+    loop.bc = bc.word;
+    loop.hl = hl.word;
+    loop.cycles = AnalyzeIdleLoop(pc, end);
+    loop.confirmed = false;
+    loop.timestamp = 0;
+  }
+
+  if (loop.cycles == 0)
+    return;
+
+  auto now = memory->GetTimestampNow();
+  auto next_event = memory->GetNextEventTimestamp();
+
+  // The loop only touches A and F. If an iteration left both unchanged and no
+  // event fired during it, all following iterations will do the same until
+  // the next event is due. A pending interrupt would be serviced right away.
+  loop.confirmed = now - loop.timestamp == std::uint64_t(loop.cycles) &&
+                   next_event == loop.next_event &&
+                   GetRegW(RegW::AF) == loop.af &&
+                   !(interrupt_master_enable && interrupt_requested);
+  loop.af = GetRegW(RegW::AF);
+  loop.timestamp = now;
+  loop.next_event = next_event;
+}
+
+template <typename Bus>
+void CPU<Bus>::DetectIdleLoop(Block const* block) {
+  auto const& last = block->ops.back();
+  auto end = std::uint16_t(last.address + last.length);
+  // JR and JP take part in idle loop detection when jumping backwards.
+  switch (last.opcode) {
+    case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+    case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA:
+      if (pc < end)
+        DetectIdleLoop(end);
+      break;
+  }
+}
+
+template <typename Bus>
+auto CPU<Bus>::AnalyzeIdleLoop(std::uint16_t address, std::uint16_t end) -> int {
+  auto bank = memory->GetCodeBank(address);
+  if (bank < 0 || end - address > kMaxIdleLoopLength || memory->GetCodeBank(end - 1) != bank)
+    return 0;
+
+  auto start = address;
+  int ticks = 0;
+
+  // Only accept straight-line code that reads memory which nothing but a
+  // scheduled event can change and that writes nothing but A and F.
+  while (address < end) {
+    auto opcode = memory->ReadCode(address);
+    auto length = kOpcodeLength[opcode];
+    auto imm8 = memory->ReadCode(address + 1);
+    auto imm16 = imm8 | (memory->ReadCode(address + 2) << 8);
+    auto next = std::uint16_t(address + length);
+
+    if (next > end)
+      return 0;
+
+    switch (opcode) {
+      // LD A, (u16) and LDH A, (u8)
+      case 0xFA:
+        if (!IsIdlePollAddress(imm16))
+          return 0;
+        ticks += 4;
+        break;
+      case 0xF0:
+        if (!IsIdlePollAddress(0xFF00 | imm8))
+          return 0;
+        ticks += 3;
+        break;
+      // LD A, (C)
+      case 0xF2:
+        if (!IsIdlePollAddress(0xFF00 | bc.byte.lo))
+          return 0;
+        ticks += 2;
+        break;
+      // LD A, (HL) and ALU A, (HL)
+      case 0x7E:
+      case 0xA6:
+      case 0xAE:
+      case 0xB6:
+      case 0xBE:
+        if (!IsIdlePollAddress(hl.word))
+          return 0;
+        ticks += 2;
+        break;
+      // AND, XOR, OR and CP A, r
+      case 0xA0 ... 0xA5:
+      case 0xA7 ... 0xAD:
+      case 0xAF ... 0xB5:
+      case 0xB7 ... 0xBD:
+      case 0xBF:
+        ticks += 1;
+        break;
+      // AND, XOR, OR and CP A, u8
+      case 0xE6:
+      case 0xEE:
+      case 0xF6:
+      case 0xFE:
+        ticks += 2;
+        break;
+      // BIT n, r and BIT n, (HL)
+      case 0xCB:
+        if ((imm8 & 0xC0) != 0x40)
+          return 0;
+        if ((imm8 & 7) == 6) {
+          if (!IsIdlePollAddress(hl.word))
+            return 0;
+          ticks += 1;
+        }
+        ticks += 2;
+        break;
+      // JR and JR cc back to the start of the loop
+      case 0x18:
+      case 0x20:
+      case 0x28:
+      case 0x30:
+      case 0x38:
+        if (next != end || std::uint16_t(next + std::int8_t(imm8)) != start)
+          return 0;
+        ticks += 2;
+        break;
+      // JP and JP cc back to the start of the loop
+      case 0xC2:
+      case 0xC3:
+      case 0xCA:
+      case 0xD2:
+      case 0xDA:
+        if (next != end || imm16 != start)
+          return 0;
+        ticks += 3;
+        break;
+      default:
+        return 0;
+    }
+
+    address = next;
+  }
+
+  return ticks * 4;
+}
+
+template <typename Bus>
+auto CPU<Bus>::IsIdlePollAddress(std::uint16_t address) -> bool {
+  switch (address) {
+    // ROM, WRAM and HRAM only change when the CPU writes to them.
+    case 0x0000 ... 0x7FFF:
+    case 0xC000 ... 0xDFFF:
+    case 0xFF80 ... 0xFFFE:
+    // IF, STAT and LY are only updated by scheduled events.
+    case 0xFF0F:
+    case 0xFF41:
+    case 0xFF44:
+      return true;
+    default:
+      return false;
+  }
+}
+
+template void CPU<Memory>::DetectIdleLoop(std::uint16_t end);
+template void CPU<Memory>::DetectIdleLoop(Block const* block);
+template auto CPU<Memory>::AnalyzeIdleLoop(std::uint16_t address, std::uint16_t end) -> int;
+template auto CPU<Memory>::IsIdlePollAddress(std::uint16_t address) -> bool;
+
+template void CPU<MemoryBase>::DetectIdleLoop(std::uint16_t end);
+template void CPU<MemoryBase>::DetectIdleLoop(Block const* block);
+template auto CPU<MemoryBase>::AnalyzeIdleLoop(std::uint16_t address, std::uint16_t end) -> int;
+template auto CPU<MemoryBase>::IsIdlePollAddress(std::uint16_t address) -> bool;
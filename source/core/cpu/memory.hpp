@@ -14,6 +14,23 @@ struct MemoryBase {
   virtual void WriteByte(std::uint16_t address, std::uint8_t value) = 0;
   virtual auto GetROM1Bank() -> std::uint8_t = 0;
 
+  /// Advances time by one memory access without touching the bus.
+  virtual void Tick() = 0;
+
+  /// Identifies the ROM bank mapped at an address for caching decoded code.
+  /// Returns -1 if the address does not map to ROM.
+  virtual auto GetCodeBank(std::uint16_t address) -> int = 0;
+
+  /// Reads ROM without side effects, used for decoding cached code.
+  virtual auto ReadCode(std::uint16_t address) -> std::uint8_t = 0;
+
+  /// Current time in cycles.
+  virtual auto GetTimestampNow() const -> std::uint64_t = 0;
+
+  /// Time of the next scheduled event. Until then only the CPU can change the
+  /// state of the system.
+  virtual auto GetNextEventTimestamp() const -> std::uint64_t = 0;
+
   auto ReadWord(std::uint16_t address) -> std::uint16_t {
     return ReadByte(address) | (ReadByte(address + 1) << 8);
   }
@@ -22,4 +39,7 @@ struct MemoryBase {
     WriteByte(address, value & 0xFF);
     WriteByte(address + 1, value >> 8);
   }
+
+  /// Incremented whenever a different ROM bank may have been mapped.
+  std::uint32_t code_generation = 0;
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Maximum number of instructions decoded into a single block.
+constexpr std::size_t kMaxBlockLength = 64;
+
+/// Size of each instruction in bytes, including the opcode.
+constexpr std::uint8_t kOpcodeLength[256] {
+  /* 0x0X */ 1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1,
+  /* 0x1X */ 1, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+  /* 0x2X */ 2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+  /* 0x3X */ 2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1,
+  /* 0x4X */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x5X */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x6X */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x7X */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x8X */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x9X */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0xAX */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0xBX */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0xCX */ 1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1,
+  /* 0xDX */ 1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 1, 2, 1,
+  /* 0xEX */ 2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1,
+  /* 0xFX */ 2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1
+};
+
+/// Checks if an opcode may not continue execution at the next instruction.
+constexpr auto EndsBlock(std::uint8_t opcode) -> bool {
+  switch (opcode) {
+    // STOP, HALT
+    case 0x10:
+    case 0x76:
+    // JR
+    case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+    // JP
+    case 0xC2: case 0xC3: case 0xCA: case 0xD2: case 0xDA: case 0xE9:
+    // CALL
+    case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC:
+    // RET, RETI
+    case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: case 0xD9:
+    // RST
+    case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+    case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+    // unused opcodes
+    case 0xD3: case 0xDB: case 0xDD: case 0xE3: case 0xE4:
+    case 0xEB: case 0xEC: case 0xED: case 0xF4: case 0xFC: case 0xFD:
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+  #define REBOY_RECOMPILER_X64
+  #include <sys/mman.h>
+  #if defined(__APPLE__)
+    #include <pthread.h>
+  #endif
+#endif
+
+/// Executable memory for code generated by the recompiler. Nothing is mapped
+/// until Map() is called. On unsupported hosts no memory is available and
+/// nothing will be compiled.
+class CodeBuffer {
+public:
+  CodeBuffer(std::size_t capacity) : capacity(capacity) {}
+
+  CodeBuffer(CodeBuffer const&) = delete;
+  auto operator=(CodeBuffer const&) -> CodeBuffer& = delete;
+
+ ~CodeBuffer() {
+  #ifdef REBOY_RECOMPILER_X64
+    if (data != nullptr)
+      munmap(data, capacity);
+  #endif
+  }
+
+  /// Maps the memory, unless it is mapped already.
+  void Map() {
+  #ifdef REBOY_RECOMPILER_X64
+    if (data != nullptr)
+      return;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  #if defined(__APPLE__)
+    // Required for writable and executable memory under the hardened runtime.
+    flags |= MAP_JIT;
+  #endif
+    auto memory = mmap(nullptr, capacity, PROT_READ | PROT_WRITE | PROT_EXEC, flags, -1, 0);
+    if (memory != MAP_FAILED)
+      data = static_cast<std::uint8_t*>(memory);
+  #endif
+  }
+
+  auto IsAvailable() const -> bool { return data != nullptr; }
+
+  /// Copies code into the buffer. Returns nullptr if the buffer is full.
+  auto Allocate(void const* code, std::size_t size) -> void* {
+    if (data == nullptr || size > capacity - used)
+      return nullptr;
+    auto address = data + used;
+    SetWritable(true);
+    std::memcpy(address, code, size);
+    SetWritable(false);
+    used += size;
+    return address;
+  }
+
+  void Reset() {
+    used = 0;
+  }
+
+private:
+  /// Where MAP_JIT memory is either writable or executable for each thread
+  /// (W^X), switches the calling thread between both.
+  static void SetWritable(bool writable) {
+  #if defined(REBOY_RECOMPILER_X64) && defined(__APPLE__)
+    if (__builtin_available(macOS 11.0, *)) {
+      if (pthread_jit_write_protect_supported_np())
+        pthread_jit_write_protect_np(writable ? 0 : 1);
+    }
+  #else
+    (void)writable;
+  #endif
+  }
+
+  std::uint8_t* data = nullptr;
+  std::size_t capacity;
+  std::size_t used = 0;
+};
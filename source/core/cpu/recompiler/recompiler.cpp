@@ -0,0 +1,1127 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+#include "../cpu.hpp"
+#include "../../memory.hpp"
+#include "../opcode_info.hpp"
+#include "x64_emitter.hpp"
+
+/// Number of times a block is interpreted before it gets compiled.
+static constexpr int kHotBlockThreshold = 16;
+
+/// Values returned by compiled blocks.
+/// The block ran up to and including its last instruction.
+static constexpr int kBlockCompleted = 1;
+/// The block returned early, e.g. because an event is due or an interrupt
+/// will be serviced.
+static constexpr int kBlockExited = 2;
+
+template <typename Bus>
+auto CPU<Bus>::StepRecompiled(std::uint64_t deadline) -> bool {
+  // Keep interpreting a block that could not be compiled or run.
+  if (current_op != current_op_end &&
+      current_op->address == pc &&
+      current_code_generation == memory->code_generation) {
+    return StepCached();
+  }
+
+  auto block = GetBlock(pc);
+  if (block == nullptr) {
+    current_op = nullptr;
+    current_op_end = nullptr;
+    return false;
+  }
+
+  if (block->code == nullptr && code_buffer.IsAvailable() && ++block->hits == kHotBlockThreshold) {
+    CompileBlock(block);
+    // Compiling may have flushed the block cache.
+    block = GetBlock(pc);
+  }
+
+  current_code_generation = memory->code_generation;
+
+  if (block->code != nullptr) {
+    auto limit = GetCycleLimit(deadline);
+    if (limit >= block->min_cycles) {
+      current_op = nullptr;
+      current_op_end = nullptr;
+      MaterializeFlags();
+      if (block->code(this, deadline, limit) == kBlockCompleted)
+        DetectIdleLoop(block);
+      return true;
+    }
+    // Interpret just the instruction that would pass the limit, so that the
+    // rest of the block can run compiled once the event has fired.
+    current_op = block->ops.data();
+    current_op_end = current_op + 1;
+    return StepCached();
+  }
+
+  current_op = block->ops.data();
+  current_op_end = current_op + block->ops.size();
+  return StepCached();
+}
+
+template <typename Bus>
+void CPU<Bus>::RunRecompiled(std::uint64_t deadline) {
+  do {
+    // The HALT bug fetches the same opcode twice, leave it to the interpreter.
+    if (halt_bug || !StepRecompiled(deadline))
+      StepInterpreter();
+  } while (!ShouldStop(deadline));
+}
+
+template <typename Bus>
+auto CPU<Bus>::GetCycleLimit(std::uint64_t deadline) -> int {
+  if constexpr (std::is_same_v<Bus, Memory>) {
+    auto now = memory->GetTimestampNow();
+    if (now >= deadline)
+      return -1;
+    auto until_deadline = std::min<std::uint64_t>(deadline - now, std::numeric_limits<int>::max());
+    return std::min(int(until_deadline), memory->cycles_until_event - memory->cycles_pending - 1);
+  } else {
+    return -1;
+  }
+}
+
+template <typename Bus>
+void CPU<Bus>::ExecuteDecodedThunk(CPU* cpu, DecodedOp const* op) {
+  cpu->ExecuteDecoded(op);
+  // Compiled code accesses F directly.
+  cpu->MaterializeFlags();
+}
+
+#ifdef REBOY_RECOMPILER_X64
+
+/// Maps the low byte of the host flags register, as loaded by LAHF into AH,
+/// to the Z, H and C flags.
+static const auto kHostFlagTable = [] {
+  std::array<std::uint8_t, 256> table {};
+  for (int i = 0; i < 256; i++) {
+    if (i & 0x40) table[i] |= 0x80;
+    if (i & 0x10) table[i] |= 0x20;
+    if (i & 0x01) table[i] |= 0x10;
+  }
+  return table;
+}();
+
+/// Translates a block into x86-64 code, which keeps the guest registers in
+/// host registers for the whole block:
+///
+///   A = R8, F = R9, B = R10, C = R11, D = R12, E = R13, H = R14, L = R15, SP = RSI
+///
+/// RBX points to the CPU, RBP to the memory and RDI to kHostFlagTable.
+/// RAX, RCX and RDX are scratch registers. The byte at [RSP] is set once an
+/// instruction took a slow path, [RSP + 8] holds the deadline, [RSP + 16] the
+/// cycle limit and [RSP + 20] is scratch space.
+///
+/// Cycles are known at compile time and only added to the pending cycles of
+/// the memory when leaving the block or calling into C++. Memory accesses
+/// look up the page tables inline and only call into C++ for pages without
+/// host memory. Before each instruction the cycles taken by the block up to
+/// its end are compared against the limit from GetCycleLimit(), so that the
+/// next event is never passed in compiled code. The limit is updated after
+/// an instruction took a slow path, which may have changed it.
+template <typename Bus>
+struct CPU<Bus>::Compiler {
+  using Reg = X64Emitter::Reg;
+  using Mem = X64Emitter::Mem;
+  using Label = X64Emitter::Label;
+  using ALUOp = X64Emitter::ALUOp;
+  using ShiftOp = X64Emitter::ShiftOp;
+  using Condition = X64Emitter::Condition;
+
+  /// Host register of each guest register in opcode order (B, C, D, E, H, L, (HL), A).
+  static constexpr Reg kGuestReg[8] = {
+    Reg::R10, Reg::R11, Reg::R12, Reg::R13, Reg::R14, Reg::R15, Reg::None, Reg::R8
+  };
+  static constexpr Reg kA = Reg::R8;
+  static constexpr Reg kF = Reg::R9;
+  static constexpr Reg kH = Reg::R14;
+  static constexpr Reg kL = Reg::R15;
+  static constexpr Reg kSP = Reg::RSI;
+
+  /// Caller-saved registers that hold guest state or the flag table.
+  static constexpr Reg kVolatileGuestReg[6] = {
+    Reg::R8, Reg::R9, Reg::R10, Reg::R11, Reg::RSI, Reg::RDI
+  };
+  static constexpr Reg kCalleeSavedReg[6] = {
+    Reg::RBX, Reg::RBP, Reg::R12, Reg::R13, Reg::R14, Reg::R15
+  };
+
+  /// Stack space below the saved registers, keeps RSP 16-byte aligned.
+  static constexpr int kFrameSize = 24;
+  static constexpr int kDeadlineOffset = 8;
+  static constexpr int kLimitOffset = 16;
+  static constexpr int kScratchOffset = 20;
+
+  Compiler(CPU* cpu) : cpu(cpu), memory(cpu->memory) {}
+
+  /// Emits the code for a block.
+  auto Compile(Block* block) -> X64Emitter& {
+    auto const& ops = block->ops;
+
+    block->min_cycles = GetCycles(ops[0]);
+
+    epilogue = code.NewLabel();
+    EmitPrologue();
+
+    int cycles = 0;
+    for (std::size_t i = 0; i < ops.size(); i++) {
+      auto const& op = ops[i];
+      auto next_cycles = cycles + GetCycles(op);
+      auto next = std::uint16_t(op.address + op.length);
+
+      // The caller checked the first instruction against the limit.
+      if (i != 0)
+        EmitGuard(op.address, cycles, next_cycles);
+
+      start_cycles = cycles;
+      access_cycles = cycles + 4 * FetchedBytes(op);
+      first_access = true;
+      may_stop = false;
+
+      EmitOp(op);
+
+      if (i == ops.size() - 1) {
+        if (!EndsBlock(op.opcode))
+          ExitTo(next, next_cycles);
+        break;
+      }
+
+      if (may_stop)
+        EmitCheck();
+      cycles = next_cycles;
+    }
+
+    for (auto& stub : stubs)
+      stub();
+
+    code.Bind(epilogue);
+    EmitEpilogue();
+    code.Link();
+    return code;
+  }
+
+  /// Bytes fetched by an instruction on its longest path.
+  static auto FetchedBytes(DecodedOp const& op) -> int {
+    return op.prefix_cb ? 2 : op.length;
+  }
+
+  /// Memory accesses done by an instruction on its longest path.
+  static auto GetAccessCount(DecodedOp const& op) -> int {
+    auto opcode = op.opcode;
+
+    if (op.prefix_cb) {
+      if ((op.imm[0] & 7) != 6)
+        return 0;
+      return op.imm[0] >= 0x40 && op.imm[0] <= 0x7F ? 1 : 2;
+    }
+
+    switch (opcode) {
+      case 0x02: case 0x0A: case 0x12: case 0x1A:
+      case 0x22: case 0x2A: case 0x32: case 0x3A:
+      case 0x36:
+      case 0x46: case 0x4E: case 0x56: case 0x5E: case 0x66: case 0x6E: case 0x7E:
+      case 0x70 ... 0x75: case 0x77:
+      case 0x86: case 0x8E: case 0x96: case 0x9E: case 0xA6: case 0xAE: case 0xB6: case 0xBE:
+      case 0xE0: case 0xF0: case 0xE2: case 0xF2: case 0xEA: case 0xFA:
+        return 1;
+      // INC (HL) and DEC (HL) read the operand twice, like the interpreter.
+      case 0x34: case 0x35:
+        return 3;
+      // LD (u16), SP
+      case 0x08:
+      // PUSH, POP
+      case 0xC1: case 0xD1: case 0xE1: case 0xF1:
+      case 0xC5: case 0xD5: case 0xE5: case 0xF5:
+      // CALL, RET, RETI
+      case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC:
+      case 0xC0: case 0xC8: case 0xC9: case 0xD0: case 0xD8: case 0xD9:
+      // RST
+      case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+      case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+        return 2;
+      default:
+        return 0;
+    }
+  }
+
+  /// Cycles taken by an instruction on its longest path.
+  static auto GetCycles(DecodedOp const& op) -> int {
+    return 4 * (FetchedBytes(op) + GetAccessCount(op));
+  }
+
+  /// Called after an instruction took a slow path. Returns the new cycle
+  /// limit, or -1 if the block must stop.
+  static auto UpdateCycleLimit(CPU* cpu, std::uint64_t deadline) -> int {
+    if ((cpu->interrupt_master_enable && cpu->interrupt_requested) ||
+        cpu->memory->code_generation != cpu->current_code_generation) {
+      return -1;
+    }
+    return cpu->GetCycleLimit(deadline);
+  }
+
+  static auto ReadThunk(Memory* memory, std::uint16_t address) -> std::uint8_t {
+    // The cycles of this access were added by the caller, like Tick() would.
+    if (memory->cycles_pending >= memory->cycles_until_event)
+      memory->Synchronize();
+    auto page = memory->read_page[address >> 8];
+    if (page != nullptr)
+      return page[address & 0xFF];
+    return memory->ReadSlowPath(address);
+  }
+
+  static void WriteThunk(Memory* memory, std::uint16_t address, std::uint8_t value) {
+    if (memory->cycles_pending >= memory->cycles_until_event)
+      memory->Synchronize();
+    auto page = memory->write_page[address >> 8];
+    if (page != nullptr)
+      page[address & 0xFF] = value;
+    else
+      memory->WriteSlowPath(address, value);
+  }
+
+  auto OffsetOf(void const* object, void const* field) -> std::int32_t {
+    return std::int32_t(static_cast<std::uint8_t const*>(field) - static_cast<std::uint8_t const*>(object));
+  }
+
+  auto CPUField(void const* field) -> Mem { return {Reg::RBX, OffsetOf(cpu, field)}; }
+  auto MemoryField(void const* field) -> Mem { return {Reg::RBP, OffsetOf(memory, field)}; }
+  auto PendingCycles() -> Mem { return MemoryField(&memory->cycles_pending); }
+  auto StopFlag() -> Mem { return {Reg::RSP, 0}; }
+  auto CycleLimit() -> Mem { return {Reg::RSP, kLimitOffset}; }
+  auto Scratch() -> Mem { return {Reg::RSP, kScratchOffset}; }
+
+  void LoadGuest() {
+    code.MovZX8(kA, CPUField(&cpu->af.byte.hi));
+    code.MovZX8(kF, CPUField(&cpu->af.byte.lo));
+    code.MovZX8(kGuestReg[0], CPUField(&cpu->bc.byte.hi));
+    code.MovZX8(kGuestReg[1], CPUField(&cpu->bc.byte.lo));
+    code.MovZX8(kGuestReg[2], CPUField(&cpu->de.byte.hi));
+    code.MovZX8(kGuestReg[3], CPUField(&cpu->de.byte.lo));
+    code.MovZX8(kH, CPUField(&cpu->hl.byte.hi));
+    code.MovZX8(kL, CPUField(&cpu->hl.byte.lo));
+    code.MovZX16(kSP, CPUField(&cpu->sp));
+    code.Mov64(Reg::RDI, std::uint64_t(kHostFlagTable.data()));
+  }
+
+  void StoreGuest() {
+    code.Mov8(CPUField(&cpu->af.byte.hi), kA);
+    code.Mov8(CPUField(&cpu->af.byte.lo), kF);
+    code.Mov8(CPUField(&cpu->bc.byte.hi), kGuestReg[0]);
+    code.Mov8(CPUField(&cpu->bc.byte.lo), kGuestReg[1]);
+    code.Mov8(CPUField(&cpu->de.byte.hi), kGuestReg[2]);
+    code.Mov8(CPUField(&cpu->de.byte.lo), kGuestReg[3]);
+    code.Mov8(CPUField(&cpu->hl.byte.hi), kH);
+    code.Mov8(CPUField(&cpu->hl.byte.lo), kL);
+    code.Mov16(CPUField(&cpu->sp), kSP);
+  }
+
+  void EmitPrologue() {
+    for (auto reg : kCalleeSavedReg)
+      code.Push(reg);
+    code.ALU64(ALUOp::SUB, Reg::RSP, kFrameSize);
+    code.Mov64(Reg::RBX, Reg::RDI);
+    code.Mov64(Mem{Reg::RSP, kDeadlineOffset}, Reg::RSI);
+    code.Mov32(CycleLimit(), Reg::RDX);
+    code.Mov64(Reg::RBP, CPUField(&cpu->memory));
+    code.Mov8(StopFlag(), 0);
+    LoadGuest();
+  }
+
+  void EmitEpilogue() {
+    StoreGuest();
+    code.ALU64(ALUOp::ADD, Reg::RSP, kFrameSize);
+    for (int i = 5; i >= 0; i--)
+      code.Pop(kCalleeSavedReg[i]);
+    code.Ret();
+  }
+
+  void AddCycles(int cycles) {
+    if (cycles != 0)
+      code.ALU32(ALUOp::ADD, PendingCycles(), cycles);
+  }
+
+  void ExitTo(std::uint16_t address, int cycles, int status = kBlockCompleted) {
+    AddCycles(cycles);
+    code.Mov16(CPUField(&cpu->pc), address);
+    code.Mov32(Reg::RAX, std::uint32_t(status));
+    code.Jump(epilogue);
+  }
+
+  /// Leaves the block at the address in AX.
+  void ExitToAX(int cycles) {
+    AddCycles(cycles);
+    code.Mov16(CPUField(&cpu->pc), Reg::RAX);
+    code.Mov32(Reg::RAX, std::uint32_t(kBlockCompleted));
+    code.Jump(epilogue);
+  }
+
+  /// Leaves the block at the address that was already written to PC.
+  void ExitToPC(int cycles) {
+    AddCycles(cycles);
+    code.Mov32(Reg::RAX, std::uint32_t(kBlockCompleted));
+    code.Jump(epilogue);
+  }
+
+  /// Calls a memory thunk with the address in EAX and the value to write in ECX.
+  /// A read returns the value in EAX.
+  void CallThunk(void const* function, int cycles, bool write) {
+    for (auto reg : kVolatileGuestReg)
+      code.Push(reg);
+    AddCycles(cycles);
+    code.Mov32(Reg::RSI, Reg::RAX);
+    if (write)
+      code.Mov32(Reg::RDX, Reg::RCX);
+    code.Mov64(Reg::RDI, Reg::RBP);
+    code.Mov64(Reg::RAX, std::uint64_t(function));
+    code.Call(Reg::RAX);
+    AddCycles(-cycles);
+    for (int i = 5; i >= 0; i--)
+      code.Pop(kVolatileGuestReg[i]);
+    code.Mov8(StopFlag(), 1);
+    if (!write)
+      code.MovZX8(Reg::RAX, Reg::RAX);
+  }
+
+  /// Emits a memory access to the address in EAX, or to `address` if it is
+  /// known at compile time. Writes take the value from ECX, reads return it in EAX.
+  void EmitAccess(bool write, int address = -1) {
+    auto slow = code.NewLabel();
+    auto done = code.NewLabel();
+    auto cycles = access_cycles += 4;
+
+    // Once a slow path was taken, an event may be due before this access.
+    if (!first_access) {
+      code.ALU8(ALUOp::CMP, StopFlag(), 0);
+      code.Jump(Condition::NE, slow);
+    }
+
+    if (address >= 0xFF80 && address <= 0xFFFE) {
+      // HRAM has no side effects.
+      auto hram = MemoryField(&memory->hram[address & 0x7F]);
+      if (write)
+        code.Mov8(hram, Reg::RCX);
+      else
+        code.MovZX8(Reg::RAX, hram);
+    } else if (address >= 0xFF00) {
+      // MMIO always takes the slow path.
+      code.Jump(slow);
+      may_stop = true;
+    } else {
+      auto table = write ? MemoryField(&memory->write_page[0]) : MemoryField(&memory->read_page[0]);
+      if (address >= 0) {
+        table.disp += (address >> 8) * 8;
+        code.Mov64(Reg::RDX, table);
+      } else {
+        code.Mov32(Reg::RDX, Reg::RAX);
+        code.Shift32(ShiftOp::SHR, Reg::RDX, 8);
+        table.index = Reg::RDX;
+        table.scale = 8;
+        code.Mov64(Reg::RDX, table);
+      }
+      code.Test64(Reg::RDX, Reg::RDX);
+      code.Jump(Condition::E, slow);
+      auto host = address >= 0 ? Mem{Reg::RDX, address & 0xFF} : Mem{Reg::RDX, 0, Reg::RAX};
+      if (address < 0)
+        code.MovZX8(Reg::RAX, Reg::RAX);
+      if (write)
+        code.Mov8(host, Reg::RCX);
+      else
+        code.MovZX8(Reg::RAX, host);
+      may_stop = true;
+    }
+    code.Bind(done);
+
+    stubs.push_back([=]() {
+      code.Bind(slow);
+      if (address >= 0)
+        code.Mov32(Reg::RAX, std::uint32_t(address));
+      if (write)
+        CallThunk(reinterpret_cast<void const*>(&WriteThunk), cycles, true);
+      else
+        CallThunk(reinterpret_cast<void const*>(&ReadThunk), cycles, false);
+      code.Jump(done);
+    });
+
+    first_access = false;
+  }
+
+  void Read() { EmitAccess(false); }
+  void Write() { EmitAccess(true); }
+  void ReadConstant(std::uint16_t address) { EmitAccess(false, address); }
+  void WriteConstant(std::uint16_t address) { EmitAccess(true, address); }
+
+  /// Leaves the block before an instruction that would end past the limit.
+  void EmitGuard(std::uint16_t address, int cycles, int next_cycles) {
+    auto stub = code.NewLabel();
+    code.ALU32(ALUOp::CMP, CycleLimit(), next_cycles);
+    code.Jump(Condition::L, stub);
+
+    stubs.push_back([=]() {
+      code.Bind(stub);
+      ExitTo(address, cycles, kBlockExited);
+    });
+  }
+
+  /// Updates the cycle limit after an instruction that took a slow path.
+  void EmitCheck() {
+    auto stub = code.NewLabel();
+    auto resume = code.NewLabel();
+    code.ALU8(ALUOp::CMP, StopFlag(), 0);
+    code.Jump(Condition::NE, stub);
+    code.Bind(resume);
+
+    stubs.push_back([=]() {
+      code.Bind(stub);
+      code.Mov8(StopFlag(), 0);
+      for (auto reg : kVolatileGuestReg)
+        code.Push(reg);
+      code.Mov64(Reg::RDI, Reg::RBX);
+      code.Mov64(Reg::RSI, Mem{Reg::RSP, 6 * 8 + kDeadlineOffset});
+      code.Mov64(Reg::RAX, std::uint64_t(&UpdateCycleLimit));
+      code.Call(Reg::RAX);
+      for (int i = 5; i >= 0; i--)
+        code.Pop(kVolatileGuestReg[i]);
+      code.Mov32(CycleLimit(), Reg::RAX);
+      code.Jump(resume);
+    });
+  }
+
+  /// Runs an instruction through the interpreter.
+  void EmitFallback(DecodedOp const& op) {
+    StoreGuest();
+    code.Mov16(CPUField(&cpu->pc), op.address);
+    AddCycles(start_cycles);
+    code.Mov64(Reg::RDI, Reg::RBX);
+    code.Mov64(Reg::RSI, std::uint64_t(&op));
+    code.Mov64(Reg::RAX, std::uint64_t(&ExecuteDecodedThunk));
+    code.Call(Reg::RAX);
+    AddCycles(-start_cycles - GetCycles(op));
+    LoadGuest();
+    code.Mov8(StopFlag(), 1);
+    may_stop = true;
+  }
+
+  /// Loads BC, DE, HL or SP into EAX.
+  void LoadPair(int index) {
+    if (index == 3) {
+      code.Mov32(Reg::RAX, kSP);
+    } else {
+      code.Mov32(Reg::RAX, kGuestReg[index * 2]);
+      code.Shift32(ShiftOp::SHL, Reg::RAX, 8);
+      code.ALU32(ALUOp::OR, Reg::RAX, kGuestReg[index * 2 + 1]);
+    }
+  }
+
+  /// Stores the 16-bit value in EAX into BC, DE, HL or SP. Clobbers EAX.
+  void StorePair(int index) {
+    if (index == 3) {
+      code.Mov32(kSP, Reg::RAX);
+    } else {
+      code.MovZX8(kGuestReg[index * 2 + 1], Reg::RAX);
+      code.Shift32(ShiftOp::SHR, Reg::RAX, 8);
+      code.Mov32(kGuestReg[index * 2], Reg::RAX);
+    }
+  }
+
+  /// Loads the Z, H and C flags set by the last host instruction into EAX.
+  void LoadHostFlags() {
+    code.Lahf();
+    code.MovZXAH();
+    code.MovZX8(Reg::RAX, Mem{Reg::RDI, 0, Reg::RAX});
+  }
+
+  /// Copies the guest carry flag into the host carry flag.
+  void LoadGuestCarry() {
+    code.BitTest32(kF, 4);
+  }
+
+  /// Sets F from the host flags after an 8-bit ALU operation.
+  void SetALUFlags(int operation) {
+    LoadHostFlags();
+    switch (operation) {
+      // SUB, SBC, CP
+      case 2: case 3: case 7:
+        code.ALU32(ALUOp::OR, Reg::RAX, 0x40);
+        break;
+      // AND
+      case 4:
+        code.ALU32(ALUOp::AND, Reg::RAX, 0x80);
+        code.ALU32(ALUOp::OR, Reg::RAX, 0x20);
+        break;
+      // XOR, OR
+      case 5: case 6:
+        code.ALU32(ALUOp::AND, Reg::RAX, 0x80);
+        break;
+    }
+    code.Mov32(kF, Reg::RAX);
+  }
+
+  /// ADD, ADC, SUB, SBC, AND, XOR, OR or CP on A with a register or an immediate.
+  template <typename Operand>
+  void EmitALU(int operation, Operand operand) {
+    constexpr ALUOp kHostOp[8] = {
+      ALUOp::ADD, ALUOp::ADC, ALUOp::SUB, ALUOp::SBB,
+      ALUOp::AND, ALUOp::XOR, ALUOp::OR, ALUOp::CMP
+    };
+    if (operation == 1 || operation == 3)
+      LoadGuestCarry();
+    code.ALU8(kHostOp[operation], kA, operand);
+    SetALUFlags(operation);
+  }
+
+  /// INC or DEC on an 8-bit register, the carry flag is not affected.
+  void EmitIncDec(Reg reg, bool decrement) {
+    if (decrement)
+      code.Dec8(reg);
+    else
+      code.Inc8(reg);
+    LoadHostFlags();
+    code.ALU32(ALUOp::AND, Reg::RAX, 0xA0);
+    if (decrement)
+      code.ALU32(ALUOp::OR, Reg::RAX, 0x40);
+    code.ALU32(ALUOp::AND, kF, 0x10);
+    code.ALU32(ALUOp::OR, kF, Reg::RAX);
+  }
+
+  /// RLCA, RRCA, RLA and RRA, which only set the carry flag.
+  void EmitRotateA(ShiftOp op) {
+    code.Mov32(Reg::RAX, 0u);
+    if (op == ShiftOp::RCL || op == ShiftOp::RCR)
+      LoadGuestCarry();
+    code.Shift8(op, kA, 1);
+    code.Set(Condition::B, Reg::RAX);
+    code.Shift32(ShiftOp::SHL, Reg::RAX, 4);
+    code.Mov32(kF, Reg::RAX);
+  }
+
+  /// CB-prefixed operations on an 8-bit register.
+  void EmitCB(std::uint8_t opcode, Reg reg) {
+    int bit = (opcode >> 3) & 7;
+
+    switch (opcode >> 6) {
+      // Rotates, shifts and SWAP
+      case 0: {
+        constexpr ShiftOp kHostOp[8] = {
+          ShiftOp::ROL, ShiftOp::ROR, ShiftOp::RCL, ShiftOp::RCR,
+          ShiftOp::SHL, ShiftOp::SAR, ShiftOp::ROL, ShiftOp::SHR
+        };
+        bool swap = bit == 6;
+        code.Mov32(Reg::RAX, 0u);
+        code.Mov32(Reg::RCX, 0u);
+        if (bit == 2 || bit == 3)
+          LoadGuestCarry();
+        code.Shift8(kHostOp[bit], reg, swap ? 4 : 1);
+        if (!swap)
+          code.Set(Condition::B, Reg::RAX);
+        code.Test8(reg, reg);
+        code.Set(Condition::E, Reg::RCX);
+        code.Shift32(ShiftOp::SHL, Reg::RAX, 4);
+        code.Shift32(ShiftOp::SHL, Reg::RCX, 7);
+        code.ALU32(ALUOp::OR, Reg::RAX, Reg::RCX);
+        code.Mov32(kF, Reg::RAX);
+        break;
+      }
+      // BIT
+      case 1:
+        code.Mov32(Reg::RAX, 0u);
+        code.Test8(reg, std::uint8_t(1 << bit));
+        code.Set(Condition::E, Reg::RAX);
+        code.Shift32(ShiftOp::SHL, Reg::RAX, 7);
+        code.ALU32(ALUOp::OR, Reg::RAX, 0x20);
+        code.ALU32(ALUOp::AND, kF, 0x10);
+        code.ALU32(ALUOp::OR, kF, Reg::RAX);
+        break;
+      // RES
+      case 2:
+        code.ALU8(ALUOp::AND, reg, std::uint8_t(~(1 << bit)));
+        break;
+      // SET
+      case 3:
+        code.ALU8(ALUOp::OR, reg, std::uint8_t(1 << bit));
+        break;
+    }
+  }
+
+  /// Pushes the 16-bit value from two registers, or a constant if `hi` is Reg::None.
+  void EmitPush(Reg hi, Reg lo, std::uint16_t value = 0) {
+    code.ALU16(ALUOp::SUB, kSP, 2);
+    code.Mov32(Reg::RAX, kSP);
+    if (hi == Reg::None)
+      code.Mov32(Reg::RCX, std::uint32_t(value & 0xFF));
+    else
+      code.Mov32(Reg::RCX, lo);
+    Write();
+    code.Mov32(Reg::RAX, kSP);
+    code.Inc16(Reg::RAX);
+    if (hi == Reg::None)
+      code.Mov32(Reg::RCX, std::uint32_t(value >> 8));
+    else
+      code.Mov32(Reg::RCX, hi);
+    Write();
+  }
+
+  /// Pops a value into PC and leaves the block.
+  void EmitReturn() {
+    code.Mov32(Reg::RAX, kSP);
+    Read();
+    code.Mov8(CPUField(&cpu->pc), Reg::RAX);
+    code.Mov32(Reg::RAX, kSP);
+    code.Inc16(Reg::RAX);
+    Read();
+    code.Mov8(Mem{Reg::RBX, OffsetOf(cpu, &cpu->pc) + 1}, Reg::RAX);
+    code.ALU16(ALUOp::ADD, kSP, 2);
+    ExitToPC(access_cycles);
+  }
+
+  /// Emits the jump for the not taken path of a conditional instruction.
+  /// The taken path follows.
+  void EmitCondition(std::uint8_t opcode, std::uint16_t next) {
+    auto not_taken = code.NewLabel();
+    auto mask = std::uint8_t(opcode & 0x10 ? 0x10 : 0x80);
+    bool set = opcode & 8;
+    code.Test8(kF, mask);
+    code.Jump(set ? Condition::E : Condition::NE, not_taken);
+    // Only the opcode is fetched when the condition does not hold.
+    auto cycles = start_cycles + 4;
+    stubs.push_back([=]() {
+      code.Bind(not_taken);
+      ExitTo(next, cycles);
+    });
+  }
+
+  void EmitOp(DecodedOp const& op) {
+    auto opcode = op.opcode;
+    auto next = std::uint16_t(op.address + op.length);
+    auto imm16 = std::uint16_t(op.imm[0] | (op.imm[1] << 8));
+    int dst = (opcode >> 3) & 7;
+    int src = opcode & 7;
+
+    if (op.prefix_cb) {
+      auto cb = op.imm[0];
+      if ((cb & 7) != 6) {
+        EmitCB(cb, kGuestReg[cb & 7]);
+      } else {
+        LoadPair(2);
+        Read();
+        code.Mov32(Reg::RDX, Reg::RAX);
+        EmitCB(cb, Reg::RDX);
+        if (cb < 0x40 || cb > 0x7F) {
+          LoadPair(2);
+          code.Mov32(Reg::RCX, Reg::RDX);
+          Write();
+        }
+      }
+      return;
+    }
+
+    switch (opcode) {
+      // NOP, STOP
+      case 0x00:
+        break;
+      case 0x10:
+        ExitTo(next, access_cycles);
+        break;
+
+      // LD rr, u16
+      case 0x01: case 0x11: case 0x21:
+        code.Mov32(kGuestReg[(opcode >> 4) * 2], std::uint32_t(op.imm[1]));
+        code.Mov32(kGuestReg[(opcode >> 4) * 2 + 1], std::uint32_t(op.imm[0]));
+        break;
+      case 0x31:
+        code.Mov32(kSP, std::uint32_t(imm16));
+        break;
+
+      // LD (BC), A and LD (DE), A
+      case 0x02: case 0x12:
+        LoadPair(opcode >> 4);
+        code.Mov32(Reg::RCX, kA);
+        Write();
+        break;
+
+      // LD A, (BC) and LD A, (DE)
+      case 0x0A: case 0x1A:
+        LoadPair(opcode >> 4);
+        Read();
+        code.Mov32(kA, Reg::RAX);
+        break;
+
+      // LD (HL+), A and LD (HL-), A
+      case 0x22: case 0x32:
+        LoadPair(2);
+        code.Mov32(Reg::RCX, kA);
+        Write();
+        EmitStepHL(opcode == 0x32);
+        break;
+
+      // LD A, (HL+) and LD A, (HL-)
+      case 0x2A: case 0x3A:
+        LoadPair(2);
+        Read();
+        code.Mov32(kA, Reg::RAX);
+        EmitStepHL(opcode == 0x3A);
+        break;
+
+      // INC rr, DEC rr
+      case 0x03: case 0x13: case 0x23: case 0x33:
+      case 0x0B: case 0x1B: case 0x2B: case 0x3B:
+        if (opcode >> 4 == 3) {
+          if (opcode & 8)
+            code.Dec16(kSP);
+          else
+            code.Inc16(kSP);
+        } else {
+          LoadPair(opcode >> 4);
+          if (opcode & 8)
+            code.Dec16(Reg::RAX);
+          else
+            code.Inc16(Reg::RAX);
+          StorePair(opcode >> 4);
+        }
+        break;
+
+      // INC r, DEC r
+      case 0x04: case 0x0C: case 0x14: case 0x1C: case 0x24: case 0x2C: case 0x3C:
+      case 0x05: case 0x0D: case 0x15: case 0x1D: case 0x25: case 0x2D: case 0x3D:
+        EmitIncDec(kGuestReg[dst], opcode & 1);
+        break;
+
+      // INC (HL), DEC (HL)
+      case 0x34: case 0x35: {
+        bool decrement = opcode & 1;
+        // The half carry flag comes from a second read of the operand.
+        LoadPair(2);
+        Read();
+        code.Mov8(Scratch(), Reg::RAX);
+        LoadPair(2);
+        Read();
+        if (decrement)
+          code.Dec8(Reg::RAX);
+        else
+          code.Inc8(Reg::RAX);
+        LoadHostFlags();
+        code.ALU32(ALUOp::AND, Reg::RAX, 0x20);
+        code.Mov32(Reg::RCX, Reg::RAX);
+        code.MovZX8(Reg::RDX, Scratch());
+        if (decrement)
+          code.Dec8(Reg::RDX);
+        else
+          code.Inc8(Reg::RDX);
+        LoadHostFlags();
+        code.ALU32(ALUOp::AND, Reg::RAX, 0x80);
+        code.ALU32(ALUOp::OR, Reg::RAX, Reg::RCX);
+        if (decrement)
+          code.ALU32(ALUOp::OR, Reg::RAX, 0x40);
+        code.ALU32(ALUOp::AND, kF, 0x10);
+        code.ALU32(ALUOp::OR, kF, Reg::RAX);
+        LoadPair(2);
+        code.Mov32(Reg::RCX, Reg::RDX);
+        Write();
+        break;
+      }
+
+      // LD r, u8
+      case 0x06: case 0x0E: case 0x16: case 0x1E: case 0x26: case 0x2E: case 0x3E:
+        code.Mov32(kGuestReg[dst], std::uint32_t(op.imm[0]));
+        break;
+
+      // LD (HL), u8
+      case 0x36:
+        LoadPair(2);
+        code.Mov32(Reg::RCX, std::uint32_t(op.imm[0]));
+        Write();
+        break;
+
+      case 0x07: EmitRotateA(ShiftOp::ROL); break;
+      case 0x0F: EmitRotateA(ShiftOp::ROR); break;
+      case 0x17: EmitRotateA(ShiftOp::RCL); break;
+      case 0x1F: EmitRotateA(ShiftOp::RCR); break;
+
+      // LD (u16), SP
+      case 0x08:
+        code.Mov32(Reg::RCX, kSP);
+        WriteConstant(imm16);
+        code.Mov32(Reg::RCX, kSP);
+        code.Shift32(ShiftOp::SHR, Reg::RCX, 8);
+        WriteConstant(std::uint16_t(imm16 + 1));
+        break;
+
+      // ADD HL, rr
+      case 0x09: case 0x19: case 0x29: case 0x39:
+        if (opcode == 0x39) {
+          code.MovZX16(Reg::RCX, kSP);
+          code.Mov32(Reg::RDX, Reg::RCX);
+          code.Shift32(ShiftOp::SHR, Reg::RDX, 8);
+          code.ALU8(ALUOp::ADD, kL, Reg::RCX);
+          code.ALU8(ALUOp::ADC, kH, Reg::RDX);
+        } else {
+          code.ALU8(ALUOp::ADD, kL, kGuestReg[(opcode >> 4) * 2 + 1]);
+          code.ALU8(ALUOp::ADC, kH, kGuestReg[(opcode >> 4) * 2]);
+        }
+        LoadHostFlags();
+        code.ALU32(ALUOp::AND, Reg::RAX, 0x30);
+        code.ALU32(ALUOp::AND, kF, 0x80);
+        code.ALU32(ALUOp::OR, kF, Reg::RAX);
+        break;
+
+      // JR
+      case 0x18:
+        ExitTo(std::uint16_t(next + std::int8_t(op.imm[0])), access_cycles);
+        break;
+      case 0x20: case 0x28: case 0x30: case 0x38:
+        EmitCondition(opcode, next);
+        ExitTo(std::uint16_t(next + std::int8_t(op.imm[0])), access_cycles);
+        break;
+
+      // CPL, SCF, CCF
+      case 0x2F:
+        code.Not8(kA);
+        code.ALU32(ALUOp::OR, kF, 0x60);
+        break;
+      case 0x37:
+        code.ALU32(ALUOp::AND, kF, 0x80);
+        code.ALU32(ALUOp::OR, kF, 0x10);
+        break;
+      case 0x3F:
+        code.ALU32(ALUOp::AND, kF, 0x90);
+        code.ALU32(ALUOp::XOR, kF, 0x10);
+        break;
+
+      // LD r, r', LD r, (HL) and LD (HL), r
+      case 0x40 ... 0x75: case 0x77 ... 0x7F:
+        if (src == 6) {
+          LoadPair(2);
+          Read();
+          code.Mov32(kGuestReg[dst], Reg::RAX);
+        } else if (dst == 6) {
+          // The address must be read before L or H is written.
+          LoadPair(2);
+          code.Mov32(Reg::RCX, kGuestReg[src]);
+          Write();
+        } else if (dst != src) {
+          code.Mov32(kGuestReg[dst], kGuestReg[src]);
+        }
+        break;
+
+      // ALU A, r and ALU A, (HL)
+      case 0x80 ... 0xBF:
+        if (src == 6) {
+          LoadPair(2);
+          Read();
+          EmitALU(dst, Reg::RAX);
+        } else {
+          EmitALU(dst, kGuestReg[src]);
+        }
+        break;
+
+      // ALU A, u8
+      case 0xC6: case 0xCE: case 0xD6: case 0xDE: case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+        EmitALU(dst, op.imm[0]);
+        break;
+
+      // RET cc
+      case 0xC0: case 0xC8: case 0xD0: case 0xD8:
+        EmitCondition(opcode, next);
+        EmitReturn();
+        break;
+
+      // RET, RETI
+      case 0xD9:
+        code.Mov8(CPUField(&cpu->interrupt_master_enable), 1);
+        [[fallthrough]];
+      case 0xC9:
+        EmitReturn();
+        break;
+
+      // POP
+      case 0xC1: case 0xD1: case 0xE1: case 0xF1: {
+        int index = (opcode >> 4) & 3;
+        auto hi = index == 3 ? kA : kGuestReg[index * 2];
+        auto lo = index == 3 ? kF : kGuestReg[index * 2 + 1];
+        code.Mov32(Reg::RAX, kSP);
+        Read();
+        if (index == 3)
+          code.ALU32(ALUOp::AND, Reg::RAX, 0xF0);
+        code.Mov32(lo, Reg::RAX);
+        code.Mov32(Reg::RAX, kSP);
+        code.Inc16(Reg::RAX);
+        Read();
+        code.Mov32(hi, Reg::RAX);
+        code.ALU16(ALUOp::ADD, kSP, 2);
+        break;
+      }
+
+      // PUSH
+      case 0xC5: case 0xD5: case 0xE5: case 0xF5: {
+        int index = (opcode >> 4) & 3;
+        if (index == 3)
+          EmitPush(kA, kF);
+        else
+          EmitPush(kGuestReg[index * 2], kGuestReg[index * 2 + 1]);
+        break;
+      }
+
+      // JP
+      case 0xC3:
+        ExitTo(imm16, access_cycles);
+        break;
+      case 0xC2: case 0xCA: case 0xD2: case 0xDA:
+        EmitCondition(opcode, next);
+        ExitTo(imm16, access_cycles);
+        break;
+
+      // JP HL
+      case 0xE9:
+        LoadPair(2);
+        ExitToAX(access_cycles);
+        break;
+
+      // CALL
+      case 0xC4: case 0xCC: case 0xD4: case 0xDC:
+        EmitCondition(opcode, next);
+        [[fallthrough]];
+      case 0xCD:
+        EmitPush(Reg::None, Reg::None, next);
+        ExitTo(imm16, access_cycles);
+        break;
+
+      // RST
+      case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+      case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+        EmitPush(Reg::None, Reg::None, next);
+        ExitTo(opcode & 0x38, access_cycles);
+        break;
+
+      // LDH (u8), A and LDH A, (u8)
+      case 0xE0:
+        code.Mov32(Reg::RCX, kA);
+        WriteConstant(0xFF00 | op.imm[0]);
+        break;
+      case 0xF0:
+        ReadConstant(0xFF00 | op.imm[0]);
+        code.Mov32(kA, Reg::RAX);
+        break;
+
+      // LD (C), A and LD A, (C)
+      case 0xE2:
+        code.Mov32(Reg::RAX, kGuestReg[1]);
+        code.ALU32(ALUOp::OR, Reg::RAX, 0xFF00);
+        code.Mov32(Reg::RCX, kA);
+        Write();
+        break;
+      case 0xF2:
+        code.Mov32(Reg::RAX, kGuestReg[1]);
+        code.ALU32(ALUOp::OR, Reg::RAX, 0xFF00);
+        Read();
+        code.Mov32(kA, Reg::RAX);
+        break;
+
+      // LD (u16), A and LD A, (u16)
+      case 0xEA:
+        code.Mov32(Reg::RCX, kA);
+        WriteConstant(imm16);
+        break;
+      case 0xFA:
+        ReadConstant(imm16);
+        code.Mov32(kA, Reg::RAX);
+        break;
+
+      // LD SP, HL
+      case 0xF9:
+        LoadPair(2);
+        code.Mov32(kSP, Reg::RAX);
+        break;
+
+      // DI, EI
+      case 0xF3:
+        code.Mov8(CPUField(&cpu->interrupt_master_enable), 0);
+        break;
+      case 0xFB:
+        // An interrupt may be serviced right after EI.
+        code.Mov8(CPUField(&cpu->interrupt_master_enable), 1);
+        code.Mov8(StopFlag(), 1);
+        may_stop = true;
+        break;
+
+      // DAA, ADD SP, s8, LD HL, SP + s8, HALT and unused opcodes
+      default:
+        EmitFallback(op);
+        if (EndsBlock(opcode))
+          ExitToPC(start_cycles + GetCycles(op));
+        break;
+    }
+  }
+
+  /// Increments or decrements HL without touching the flags.
+  void EmitStepHL(bool decrement) {
+    code.ALU8(decrement ? ALUOp::SUB : ALUOp::ADD, kL, std::uint8_t(1));
+    code.ALU8(decrement ? ALUOp::SBB : ALUOp::ADC, kH, std::uint8_t(0));
+  }
+
+  CPU* cpu;
+  Memory* memory;
+  X64Emitter code;
+  Label epilogue;
+
+  /// Code emitted after the block, for slow paths and early exits.
+  std::vector<std::function<void()>> stubs;
+
+  /// Cycles from the start of the block to the start of the current
+  /// instruction and to its last memory access so far.
+  int start_cycles;
+  int access_cycles;
+
+  bool first_access;
+
+  /// Set if the current instruction may have taken a slow path.
+  bool may_stop;
+};
+
+template <typename Bus>
+void CPU<Bus>::CompileBlock(Block* block) {
+  if constexpr (std::is_same_v<Bus, Memory>) {
+    Compiler compiler{this};
+    auto& code = compiler.Compile(block);
+
+    auto address = code_buffer.Allocate(code.Data(), code.Size());
+    if (address == nullptr) {
+      // Out of memory for native code, start over with an empty cache.
+      FlushBlockCache();
+      return;
+    }
+    block->code = reinterpret_cast<int (*)(CPU*, std::uint64_t, int)>(address);
+  }
+}
+
+#else
+
+template <typename Bus>
+void CPU<Bus>::CompileBlock(Block* block) {
+  // Native code generation is not supported on this host.
+}
+
+#endif
+
+template auto CPU<Memory>::StepRecompiled(std::uint64_t deadline) -> bool;
+template void CPU<Memory>::RunRecompiled(std::uint64_t deadline);
+template auto CPU<Memory>::GetCycleLimit(std::uint64_t deadline) -> int;
+template void CPU<Memory>::ExecuteDecodedThunk(CPU* cpu, DecodedOp const* op);
+template void CPU<Memory>::CompileBlock(Block* block);
+
+template auto CPU<MemoryBase>::StepRecompiled(std::uint64_t deadline) -> bool;
+template void CPU<MemoryBase>::RunRecompiled(std::uint64_t deadline);
+template auto CPU<MemoryBase>::GetCycleLimit(std::uint64_t deadline) -> int;
+template void CPU<MemoryBase>::ExecuteDecodedThunk(CPU* cpu, DecodedOp const* op);
+template void CPU<MemoryBase>::CompileBlock(Block* block);
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <vector>
+
+/// Minimal x86-64 machine code emitter.
+/// Only the encodings needed by the recompiler are supported. Byte registers
+/// are AL - BL and R8B - R15B, AH is only available through MovZXAH().
+/// Memory operands always use a 32-bit displacement.
+class X64Emitter {
+public:
+  enum class Reg {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15,
+    None
+  };
+
+  enum class ALUOp {
+    ADD = 0, OR = 1, ADC = 2, SBB = 3, AND = 4, SUB = 5, XOR = 6, CMP = 7
+  };
+
+  enum class ShiftOp {
+    ROL = 0, ROR = 1, RCL = 2, RCR = 3, SHL = 4, SHR = 5, SAR = 7
+  };
+
+  enum class Condition {
+    B = 0x2, AE = 0x3, E = 0x4, NE = 0x5, L = 0xC, GE = 0xD
+  };
+
+  /// [base + index * scale + disp]
+  struct Mem {
+    Reg base;
+    std::int32_t disp = 0;
+    Reg index = Reg::None;
+    int scale = 1;
+  };
+
+  using Label = std::size_t;
+
+  auto Data() const -> std::uint8_t const* { return code.data(); }
+  auto Size() const -> std::size_t { return code.size(); }
+
+  auto NewLabel() -> Label {
+    labels.push_back(kUnbound);
+    return labels.size() - 1;
+  }
+
+  void Bind(Label label) {
+    labels[label] = code.size();
+  }
+
+  /// Patches all jumps. Every label must be bound by now.
+  void Link() {
+    for (auto const& fixup : fixups) {
+      auto rel = std::uint32_t(labels[fixup.label] - fixup.end);
+      for (int i = 0; i < 4; i++)
+        code[fixup.end - 4 + i] = std::uint8_t(rel >> (i * 8));
+    }
+    fixups.clear();
+  }
+
+  void Jump(Label label) {
+    Emit8(0xE9);
+    Emit32(0);
+    fixups.push_back({code.size(), label});
+  }
+
+  void Jump(Condition condition, Label label) {
+    Emit8(0x0F);
+    Emit8(0x80 + int(condition));
+    Emit32(0);
+    fixups.push_back({code.size(), label});
+  }
+
+  void Push(Reg reg) {
+    if (int(reg) >= 8) Emit8(0x41);
+    Emit8(0x50 + (int(reg) & 7));
+  }
+
+  void Pop(Reg reg) {
+    if (int(reg) >= 8) Emit8(0x41);
+    Emit8(0x58 + (int(reg) & 7));
+  }
+
+  void Call(Reg reg) { Op(false, false, {0xFF}, 2, reg); }
+  void Ret() { Emit8(0xC3); }
+  void Lahf() { Emit8(0x9F); }
+
+  /// movzx eax, ah
+  void MovZXAH() { Emit8(0x0F); Emit8(0xB6); Emit8(0xC4); }
+
+  void Mov32(Reg dst, Reg src) { Op(false, false, {0x89}, int(src), dst); }
+  void Mov32(Reg dst, Mem src) { Op(false, false, {0x8B}, int(dst), src); }
+  void Mov32(Mem dst, Reg src) { Op(false, false, {0x89}, int(src), dst); }
+  void Mov64(Reg dst, Reg src) { Op(false, true, {0x89}, int(src), dst); }
+  void Mov64(Reg dst, Mem src) { Op(false, true, {0x8B}, int(dst), src); }
+  void Mov64(Mem dst, Reg src) { Op(false, true, {0x89}, int(src), dst); }
+  void Mov8(Mem dst, Reg src) { Op(false, false, {0x88}, int(src), dst, true); }
+  void Mov16(Mem dst, Reg src) { Op(true, false, {0x89}, int(src), dst); }
+
+  void Mov32(Reg dst, std::uint32_t value) {
+    if (int(dst) >= 8) Emit8(0x41);
+    Emit8(0xB8 + (int(dst) & 7));
+    Emit32(value);
+  }
+
+  void Mov64(Reg dst, std::uint64_t value) {
+    Emit8(0x48 | (int(dst) >> 3));
+    Emit8(0xB8 + (int(dst) & 7));
+    Emit32(std::uint32_t(value));
+    Emit32(std::uint32_t(value >> 32));
+  }
+
+  void Mov8(Mem dst, std::uint8_t value) {
+    Op(false, false, {0xC6}, 0, dst);
+    Emit8(value);
+  }
+
+  void Mov16(Mem dst, std::uint16_t value) {
+    Op(true, false, {0xC7}, 0, dst);
+    Emit8(value & 0xFF);
+    Emit8(value >> 8);
+  }
+
+  void MovZX8(Reg dst, Reg src) { Op(false, false, {0x0F, 0xB6}, int(dst), src, true); }
+  void MovZX8(Reg dst, Mem src) { Op(false, false, {0x0F, 0xB6}, int(dst), src); }
+  void MovZX16(Reg dst, Reg src) { Op(false, false, {0x0F, 0xB7}, int(dst), src); }
+  void MovZX16(Reg dst, Mem src) { Op(false, false, {0x0F, 0xB7}, int(dst), src); }
+
+  void ALU8(ALUOp op, Reg dst, Reg src) { Op(false, false, {std::uint8_t(int(op) << 3)}, int(src), dst, true); }
+
+  void ALU8(ALUOp op, Reg dst, std::uint8_t value) {
+    Op(false, false, {0x80}, int(op), dst, true);
+    Emit8(value);
+  }
+
+  void ALU8(ALUOp op, Mem dst, std::uint8_t value) {
+    Op(false, false, {0x80}, int(op), dst);
+    Emit8(value);
+  }
+
+  void ALU16(ALUOp op, Reg dst, std::int8_t value) {
+    Op(true, false, {0x83}, int(op), dst);
+    Emit8(std::uint8_t(value));
+  }
+
+  void ALU32(ALUOp op, Reg dst, Reg src) { Op(false, false, {std::uint8_t((int(op) << 3) | 1)}, int(src), dst); }
+  void ALU32(ALUOp op, Reg dst, Mem src) { Op(false, false, {std::uint8_t((int(op) << 3) | 3)}, int(dst), src); }
+  void ALU32(ALUOp op, Reg dst, std::int32_t value) { ALUImm(false, op, dst, value); }
+  void ALU32(ALUOp op, Mem dst, std::int32_t value) { ALUImm(false, op, dst, value); }
+  void ALU64(ALUOp op, Reg dst, std::int32_t value) { ALUImm(true, op, dst, value); }
+
+  void Inc8(Reg reg) { Op(false, false, {0xFE}, 0, reg, true); }
+  void Dec8(Reg reg) { Op(false, false, {0xFE}, 1, reg, true); }
+  void Not8(Reg reg) { Op(false, false, {0xF6}, 2, reg, true); }
+  void Inc16(Reg reg) { Op(true, false, {0xFF}, 0, reg); }
+  void Dec16(Reg reg) { Op(true, false, {0xFF}, 1, reg); }
+
+  void Shift8(ShiftOp op, Reg reg, std::uint8_t amount) {
+    if (amount == 1) {
+      Op(false, false, {0xD0}, int(op), reg, true);
+    } else {
+      Op(false, false, {0xC0}, int(op), reg, true);
+      Emit8(amount);
+    }
+  }
+
+  void Shift32(ShiftOp op, Reg reg, std::uint8_t amount) {
+    Op(false, false, {0xC1}, int(op), reg);
+    Emit8(amount);
+  }
+
+  void Test8(Reg reg, Reg other) { Op(false, false, {0x84}, int(other), reg, true); }
+  void Test64(Reg reg, Reg other) { Op(false, true, {0x85}, int(other), reg); }
+
+  void Test8(Reg reg, std::uint8_t value) {
+    Op(false, false, {0xF6}, 0, reg, true);
+    Emit8(value);
+  }
+
+  /// Copies a bit into the carry flag.
+  void BitTest32(Reg reg, std::uint8_t bit) {
+    Op(false, false, {0x0F, 0xBA}, 4, reg);
+    Emit8(bit);
+  }
+
+  void Set(Condition condition, Reg reg) {
+    Op(false, false, {0x0F, std::uint8_t(0x90 + int(condition))}, 0, reg, true);
+  }
+
+private:
+  static constexpr std::size_t kUnbound = std::numeric_limits<std::size_t>::max();
+
+  struct Fixup {
+    std::size_t end;
+    Label label;
+  };
+
+  void Emit8(std::uint8_t value) {
+    code.push_back(value);
+  }
+
+  void Emit32(std::uint32_t value) {
+    for (int i = 0; i < 4; i++)
+      Emit8(std::uint8_t(value >> (i * 8)));
+  }
+
+  template <typename Operand>
+  void ALUImm(bool wide, ALUOp op, Operand dst, std::int32_t value) {
+    if (value >= -128 && value <= 127) {
+      Op(false, wide, {0x83}, int(op), dst);
+      Emit8(std::uint8_t(value));
+    } else {
+      Op(false, wide, {0x81}, int(op), dst);
+      Emit32(std::uint32_t(value));
+    }
+  }
+
+  /// Emits an instruction with a register operand in the r/m field.
+  /// With `byte_regs` SPL - DIL need a REX prefix to be addressed.
+  void Op(bool prefix_16, bool wide, std::initializer_list<std::uint8_t> opcode, int reg, Reg rm, bool byte_regs = false) {
+    auto rex = 0x40 | (wide ? 8 : 0) | ((reg >> 3) << 2) | (int(rm) >> 3);
+    bool needs_rex = rex != 0x40 || (byte_regs && ((reg >= 4 && reg < 8) || (int(rm) >= 4 && int(rm) < 8)));
+    if (prefix_16) Emit8(0x66);
+    if (needs_rex) Emit8(std::uint8_t(rex));
+    for (auto byte : opcode) Emit8(byte);
+    Emit8(std::uint8_t(0xC0 | ((reg & 7) << 3) | (int(rm) & 7)));
+  }
+
+  /// Emits an instruction with a memory operand in the r/m field.
+  void Op(bool prefix_16, bool wide, std::initializer_list<std::uint8_t> opcode, int reg, Mem rm, bool byte_regs = false) {
+    auto base = int(rm.base);
+    auto index = rm.index == Reg::None ? 4 : int(rm.index);
+    auto rex = 0x40 | (wide ? 8 : 0) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (base >> 3);
+    bool needs_rex = rex != 0x40 || (byte_regs && reg >= 4 && reg < 8);
+    if (prefix_16) Emit8(0x66);
+    if (needs_rex) Emit8(std::uint8_t(rex));
+    for (auto byte : opcode) Emit8(byte);
+
+    if (rm.index == Reg::None && (base & 7) != 4) {
+      Emit8(std::uint8_t(0x80 | ((reg & 7) << 3) | (base & 7)));
+    } else {
+      int scale = rm.scale == 8 ? 3 : rm.scale == 4 ? 2 : rm.scale == 2 ? 1 : 0;
+      Emit8(std::uint8_t(0x84 | ((reg & 7) << 3)));
+      Emit8(std::uint8_t((scale << 6) | ((index & 7) << 3) | (base & 7)));
+    }
+    Emit32(std::uint32_t(rm.disp));
+  }
+
+  std::vector<std::uint8_t> code;
+  std::vector<std::size_t> labels;
+  std::vector<Fixup> fixups;
+};
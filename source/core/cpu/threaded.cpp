@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "cpu.hpp"
+#include "../memory.hpp"
+
+template <typename Bus>
+void CPU<Bus>::RunThreaded(std::uint64_t deadline) {
+  // The HALT bug fetches the same opcode twice, leave it to the interpreter.
+  if (halt_bug) {
+    Step();
+    return;
+  }
+
+#if defined(__GNUC__)
+  using Handler = void (CPU::*)(void);
+
+  // Each opcode has its own copy of the dispatch branch, which predicts much
+  // better than a single indirect call. CB opcodes live in the upper half.
+  static void* const kDispatchTable[512] {
+    #define OP(opcode, ...) opcode == 0xCB ? &&prefix_cb : &&op_##opcode,
+    #include "opcode_table.inc"
+    #undef OP
+    #define OP(opcode, ...) &&cb_##opcode,
+    #include "opcode_table_cb.inc"
+    #undef OP
+  };
+
+  #define DISPATCH() \
+    if (ShouldStop(deadline)) return; \
+    goto *kDispatchTable[memory->ReadByte(pc++)];
+
+  goto *kDispatchTable[memory->ReadByte(pc++)];
+
+prefix_cb:
+  goto *kDispatchTable[256 + FetchByte()];
+
+  #define OP(opcode, ...) op_##opcode: (this->*Handler{__VA_ARGS__})(); DISPATCH()
+  #include "opcode_table.inc"
+  #undef OP
+
+  #define OP(opcode, ...) cb_##opcode: (this->*Handler{__VA_ARGS__})(); DISPATCH()
+  #include "opcode_table_cb.inc"
+  #undef OP
+
+  #undef DISPATCH
+#else
+  do {
+    Step();
+  } while (!ShouldStop(deadline));
+#endif
+}
+
+template void CPU<Memory>::RunThreaded(std::uint64_t deadline);
+template void CPU<MemoryBase>::RunThreaded(std::uint64_t deadline);
@@ -11,6 +11,7 @@
 #include <fstream>
 #include <string>
 #include <memory>
+#include <unordered_set>
 
 #include "apu/apu.hpp"
 #include "cpu/cpu.hpp"
@@ -25,6 +26,14 @@
 
 class GameBoy {
 public:
+  /// Why RunUntil(), RunCycles() or RunFrames() returned.
+  enum class StopReason {
+    Target,
+    FrameEnd,
+    VBlank,
+    Breakpoint
+  };
+
   GameBoy() :
     irq(&cpu),
     ppu(&scheduler, &irq),
@@ -46,6 +55,10 @@ public:
 
   auto GetJoypad() -> Joypad& { return joypad; }
 
+  void SetCPUBackend(CPUBackend backend) {
+    cpu.SetBackend(backend);
+  }
+
   void SetAudioDevice(AudioDevice* device) {
     apu.SetAudioDevice(device);
   }
@@ -99,6 +112,7 @@ public:
 
     auto data = std::make_unique<std::uint8_t[]>(size);
     file.read((char*)data.get(), size);
+    rom_hash = AOTHashROM(data.get(), size);
 
     // FIXME: remove original file extension.
     auto save_path = path + ".sav";
@@ -129,28 +143,190 @@ public:
     }
 
     memory.mapper = mapper.get();
+    cpu.SetAOTModule(nullptr);
+    aot_module.reset();
+    Reset();
+    return true;
+  }
+
+  /// Loads code generated by the ahead-of-time recompiler for the current game.
+  /// Takes effect with the CPUBackend::Precompiled backend.
+  bool LoadAOTModule(std::string const& path) {
+    auto module = std::make_unique<AOTModule>();
+
+    if (!module->Load(path))
+      return false;
+
+    if (module->GetROMHash() != rom_hash) {
+      std::printf("AOT module %s was generated from a different ROM\n", path.c_str());
+      return false;
+    }
+
+    aot_module = std::move(module);
+    cpu.SetAOTModule(aot_module.get());
     return true;
   }
 
+  /// Sets the frame buffer the PPU renders to. Passing nullptr skips rendering.
+  void SetBuffer(std::uint32_t* buffer) {
+    ppu.SetBuffer(buffer, PixelFormat::ARGB8888);
+  }
+
+  /// Sets a frame buffer in any of the supported formats. It must hold
+  /// 144 lines of 160 pixels.
+  void SetBuffer(void* buffer, PixelFormat format) {
+    ppu.SetBuffer(buffer, format);
+  }
+
+  /// True if the last completed frame is identical to the one before it,
+  /// so that the frame buffer does not need to be presented again.
+  /// With threaded rendering this refers to the frames completed up to the
+  /// previous call of RunUntil() and friends, like the frame buffer itself.
+  auto IsFrameUnchanged() const -> bool {
+    return ppu.IsFrameUnchanged();
+  }
+
+  /// Draws the frames on a worker thread, in parallel to the emulation.
+  /// The frame buffer then holds the frames completed up to the previous
+  /// call of RunUntil() and friends, instead of the current one.
+  void SetThreadedRendering(bool enable) {
+    ppu.SetThreadedRendering(enable);
+  }
+
+  /// Skips rendering of the first `skip` out of every `period` frames,
+  /// e.g. SetFrameSkip(3, 4) draws every fourth frame. (0, 0) draws all frames.
+  void SetFrameSkip(int skip, int period) {
+    ppu.SetFrameSkip(skip, period);
+  }
+
+  /// Skips rendering of all frames before frame number `frame`.
+  void SkipFramesUntil(std::uint64_t frame) {
+    ppu.SkipFramesUntil(frame);
+  }
+
+  auto GetFrameCount() const -> std::uint64_t {
+    return ppu.GetFrameCount();
+  }
+
+  /// Makes RunUntil() and friends return as soon as the PPU enters VBlank.
+  void SetStopOnVBlank(bool enable) {
+    stop_on_vblank = enable;
+  }
+
+  /// Breakpoints are checked before each CPU step. The recompiling backends
+  /// step a whole block at a time, so only block entries are hit with them.
+  void AddBreakpoint(std::uint16_t address) {
+    breakpoints.insert(address);
+  }
+
+  void RemoveBreakpoint(std::uint16_t address) {
+    breakpoints.erase(address);
+  }
+
+  void ClearBreakpoints() {
+    breakpoints.clear();
+  }
+
+  /// Address of the next instruction, e.g. of the breakpoint that was hit.
+  auto GetPC() const -> std::uint16_t {
+    return cpu.GetPC();
+  }
+
+  auto GetTimestampNow() -> std::uint64_t {
+    return memory.GetTimestampNow();
+  }
+
+  /// Reads memory like the CPU would, but without taking time or touching
+  /// MMIO registers. Meant for debuggers and tests.
+  auto Peek(std::uint16_t address) -> std::uint8_t {
+    return memory.Peek(address);
+  }
+
+  /// Runs the emulation until `timestamp` is reached or a stop condition hits.
+  auto RunUntil(std::uint64_t timestamp) -> StopReason {
+    auto target = timestamp;
+    auto reason = StopReason::Target;
+
+    ppu.ReleaseFrames();
+
+    if (stop_on_vblank) {
+      auto vblank = ppu.GetNextVBlankTimestamp();
+      if (vblank <= target) {
+        target = vblank;
+        reason = StopReason::VBlank;
+      }
+    }
+
+    if (breakpoints.empty()) {
+      Run(target);
+    } else if (RunWithBreakpoints(target)) {
+      reason = StopReason::Breakpoint;
+    }
+
+    memory.Synchronize();
+    ppu.WaitForFrames();
+    return reason;
+  }
+
+  auto RunCycles(int cycles) -> StopReason {
+    return RunUntil(memory.GetTimestampNow() + cycles);
+  }
+
+  auto RunFrames(int frames) -> StopReason {
+    auto reason = RunUntil(memory.GetTimestampNow() + std::uint64_t(frames) * kCyclesPerFrame);
+    if (reason == StopReason::Target)
+      reason = StopReason::FrameEnd;
+    return reason;
+  }
+
   void Frame(std::uint32_t* buffer) {
-    auto target = scheduler.GetTimestampNow() + 70224;
+    SetBuffer(buffer);
+    RunFrames(1);
+  }
 
-    ppu.SetBuffer(buffer);
+private:
+  static constexpr int kCyclesPerFrame = 70224;
 
-    while (scheduler.GetTimestampNow() < target) {
-      if (cpu.IsHalted()) {
-        // TODO: fast skip to the next event?
-        scheduler.AddCycles(4);
-        scheduler.Step();
-        apu.Step(); // weird but does the job.
+  void Run(std::uint64_t target) {
+    while (memory.GetTimestampNow() < target) {
+      if (cpu.IsHalted() && !cpu.interrupt_requested) {
+        // Nothing can happen until the next event fires.
+        memory.FastForward(target);
+      } else if (cpu.IsHalted()) {
+        memory.Tick();
       } else {
-        cpu.Step();
+        cpu.Run(target);
+        if (cpu.IsIdleLooping())
+          memory.SkipIdleLoop(cpu.GetIdleLoopCycles(), target);
       }
-      irq.Step();
+      if (cpu.interrupt_requested)
+        irq.Step();
     }
   }
 
-private:
+  /// Steps the CPU one instruction at a time and stops before executing an
+  /// instruction at a breakpoint. The instruction at the start address is
+  /// always executed, so that a stopped run can be resumed.
+  /// Returns true if a breakpoint was hit.
+  auto RunWithBreakpoints(std::uint64_t target) -> bool {
+    bool first = true;
+    while (memory.GetTimestampNow() < target) {
+      if (cpu.IsHalted() && !cpu.interrupt_requested) {
+        memory.FastForward(target);
+      } else if (cpu.IsHalted()) {
+        memory.Tick();
+      } else {
+        if (!first && breakpoints.count(cpu.GetPC()) != 0)
+          return true;
+        cpu.Step(target);
+      }
+      first = false;
+      if (cpu.interrupt_requested)
+        irq.Step();
+    }
+    return false;
+  }
+
   Scheduler scheduler;
   IRQ irq;
   PPU ppu;
@@ -158,6 +334,10 @@ private:
   Timer timer;
   Joypad joypad;
   Memory memory;
-  CPU cpu;
+  CPU<Memory> cpu;
   std::unique_ptr<MBCBase> mapper;
+  std::unique_ptr<AOTModule> aot_module;
+  std::uint32_t rom_hash = 0;
+  bool stop_on_vblank = false;
+  std::unordered_set<std::uint16_t> breakpoints;
 };
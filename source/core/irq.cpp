@@ -7,7 +7,7 @@
 
 #include "irq.hpp"
 
-IRQ::IRQ(CPU* cpu) : cpu(cpu) {
+IRQ::IRQ(CPU<Memory>* cpu) : cpu(cpu) {
   Reset();
 }
 
@@ -19,22 +19,22 @@ void IRQ::Reset() {
 void IRQ::Step() {
   constexpr std::uint8_t kIRQVectors[] = {
           0x40, 0x48, 0x50, 0x58, 0x60 };
-  auto enabled_and_requested = _ie & _if;
+  auto enabled_and_requested = _ie & _if & 0x1F;
   if (enabled_and_requested == 0)
     return;
-  for (int i = 0; i <= 4; i++) {
-    if (enabled_and_requested & (1 << i)) {
-      // FIXME: let RaiseIRQ decide if the IRQ will be acknowledged.
-      if (cpu->interrupt_master_enable)
-        _if &= ~(1 << i);
-      cpu->RaiseIRQ(kIRQVectors[i]);
-      break;
-    }
+  // The lowest pending interrupt has the highest priority.
+  auto i = __builtin_ctz(enabled_and_requested);
+  // FIXME: let RaiseIRQ decide if the IRQ will be acknowledged.
+  if (cpu->interrupt_master_enable) {
+    _if &= ~(1 << i);
+    UpdateRequested();
   }
+  cpu->RaiseIRQ(kIRQVectors[i]);
 }
 
 void IRQ::Raise(Interrupts irq) {
   _if |= irq;
+  UpdateRequested();
 }
 
 auto IRQ::ReadMMIO(std::uint8_t reg) -> std::uint8_t {
@@ -48,4 +48,9 @@ void IRQ::WriteMMIO(std::uint8_t reg, std::uint8_t value) {
     _if = value;
   else
     _ie = value;
+  UpdateRequested();
+}
+
+void IRQ::UpdateRequested() {
+  cpu->interrupt_requested = (_ie & _if & 0x1F) != 0;
 }
@@ -9,6 +9,8 @@
 
 #include "cpu/cpu.hpp"
 
+class Memory;
+
 class IRQ {
 public:
   enum Registers {
@@ -24,16 +26,22 @@ public:
     JOYPAD = 16
   };
 
-  IRQ(CPU* cpu);
+  IRQ(CPU<Memory>* cpu);
 
   void Reset();
+
+  /// Services the highest priority interrupt. Only needs to be called while
+  /// the CPU's `interrupt_requested` flag is set.
   void Step();
   void Raise(Interrupts irq);
   auto ReadMMIO(std::uint8_t reg) -> std::uint8_t;
   void WriteMMIO(std::uint8_t reg, std::uint8_t value);
 
 private:
-  CPU* cpu;
+  /// Mirrors whether any enabled interrupt is requested into the CPU.
+  void UpdateRequested();
+
+  CPU<Memory>* cpu;
   std::uint8_t _ie;
   std::uint8_t _if;
 };
@@ -104,6 +104,11 @@ public:
     stream.write((char*)&memory[index], length);
   }
 
+  auto GetSize() const -> size_t { return file_size; }
+
+  /// Direct read access, writes must go through Write() to update the file.
+  auto GetData() const -> std::uint8_t const* { return memory.get(); }
+
   bool auto_update = true;
 
 private:
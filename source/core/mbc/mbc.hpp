@@ -16,4 +16,11 @@ public:
   virtual auto Read(std::uint16_t address) -> std::uint8_t = 0;
   virtual void Write(std::uint16_t address, std::uint8_t value) = 0;
   virtual auto GetROM1Bank() -> std::uint8_t { return 1; }
+
+  /// Returns host memory backing the 256 byte page at an address, or nullptr
+  /// if reads must go through Read(), e.g. because they are out of bounds.
+  virtual auto GetReadPage(std::uint16_t /*address*/) -> std::uint8_t const* { return nullptr; }
+
+  /// Incremented whenever a different ROM or RAM bank is mapped.
+  std::uint32_t mapping_generation = 0;
 };
@@ -45,17 +45,50 @@ public:
     }
   }
 
+  auto GetReadPage(std::uint16_t address) -> std::uint8_t const* override {
+    switch (address >> 12) {
+      // ROM bank 0
+      case 0x0 ... 0x3:
+        if (address < size)
+          return &data[address];
+        return nullptr;
+      // ROM bank N
+      case 0x4 ... 0x7: {
+        auto effective_address = (rom_bank << 14) | (address & 0x3FFF);
+        if (effective_address < size)
+          return &data[effective_address];
+        return nullptr;
+      }
+      // SRAM bank, writes still go through Write() to update the save file.
+      case 0xA ... 0xB: {
+        auto effective_address = (ram_bank << 13) | (address & 0x1FFF);
+        if (effective_address + 0x100 <= sram->GetSize())
+          return sram->GetData() + effective_address;
+        return nullptr;
+      }
+    }
+    return nullptr;
+  }
+
   void Write(std::uint16_t address, std::uint8_t value) override {
     switch (address >> 12) {
       // ROM Bank Number
-      case 0x2 ... 0x3:
-        rom_bank = value & 0x7F;
-        if (rom_bank == 0)
-          rom_bank = 1;
+      case 0x2 ... 0x3: {
+        std::uint8_t bank = value & 0x7F;
+        if (bank == 0)
+          bank = 1;
+        if (bank != rom_bank) {
+          rom_bank = bank;
+          mapping_generation++;
+        }
         break;
+      }
       // RAM Bank Number
       case 0x4 ... 0x5:
-        ram_bank = value & 3;
+        if ((value & 3) != ram_bank) {
+          ram_bank = value & 3;
+          mapping_generation++;
+        }
         break;
       // SRAM bank
       case 0xA ... 0xB:
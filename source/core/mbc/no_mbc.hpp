@@ -25,6 +25,12 @@ public:
     }
   }
 
+  auto GetReadPage(std::uint16_t address) -> std::uint8_t const* override {
+    if (address <= 0x7FFF && address < size)
+      return &data[address];
+    return nullptr;
+  }
+
   void Write(std::uint16_t address, std::uint8_t value) override {
     // ...
   }
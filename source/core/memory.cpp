@@ -16,13 +16,66 @@ void Memory::Reset() {
   std::memset(wram, 0, 0x2000);
   std::memset(hram, 0, 0x7F);
   bootrom_disable = false;
+  cycles_pending = 0;
+  cycles_until_event = scheduler->GetRemainingCycleCount();
+  UpdatePageTable();
 }
 
-auto Memory::ReadByte(std::uint16_t address) -> std::uint8_t {
-  scheduler->AddCycles(4);
-  scheduler->Step();
-  apu->Step(); // weird but does the job.
+void Memory::Synchronize() {
+  if (cycles_pending != 0) {
+    // Events may change the channel outputs, so only the last cycle is sampled after them.
+    apu->Step(cycles_pending / 4 - 1);
+    scheduler->AddCycles(cycles_pending);
+    scheduler->Step();
+    apu->Step(1);
+    cycles_pending = 0;
+  }
+  cycles_until_event = scheduler->GetRemainingCycleCount();
+}
+
+void Memory::UpdatePageTable() {
+  for (int page = 0; page < 256; page++) {
+    read_page[page] = nullptr;
+    write_page[page] = nullptr;
+  }
 
+  // ROM and External RAM
+  if (mapper != nullptr) {
+    for (int page = 0x00; page <= 0x7F; page++)
+      read_page[page] = mapper->GetReadPage(page << 8);
+    for (int page = 0xA0; page <= 0xBF; page++)
+      read_page[page] = mapper->GetReadPage(page << 8);
+  }
+
+  if (!bootrom_disable)
+    read_page[0x00] = boot;
+
+  // Work RAM and ECHO
+  for (int page = 0xC0; page <= 0xFD; page++) {
+    auto address = page << 8;
+    std::uint8_t* host;
+    if (page <= 0xDF)
+      host = &wram[address & 0x1FFF];
+    else if (page <= 0xEF)
+      host = &wram[address & 0xFFF];
+    else
+      host = &wram[0x1000 + (address & 0xDFF)];
+    read_page[page] = host;
+    write_page[page] = host;
+  }
+}
+
+auto Memory::GetCodeBank(std::uint16_t address) -> int {
+  if (mapper == nullptr || address >= 0x8000)
+    return -1;
+  if (!bootrom_disable && address <= 0xFF)
+    return -1;
+  if (address <= 0x3FFF)
+    return 0;
+  return mapper->GetROM1Bank();
+}
+
+auto Memory::ReadSlowPath(std::uint16_t address) -> std::uint8_t {
   switch (address >> 12) {
     // ROM and External RAM
     case 0x0 ... 0x7:
@@ -64,6 +117,7 @@ auto Memory::ReadByte(std::uint16_t address) -> std::uint8_t {
       }
       // MMIO
       if (address <= 0xFF7F || address == 0xFFFF) {
+        Synchronize();
         return ReadMMIO(address & 0xFF);
       }
       // HRAM
@@ -72,17 +126,19 @@ auto Memory::ReadByte(std::uint16_t address) -> std::uint8_t {
   }
 }
 
-void Memory::WriteByte(std::uint16_t address, std::uint8_t value) {
-  scheduler->AddCycles(4);
-  scheduler->Step();
-  apu->Step(); // weird but does the job.
-
+void Memory::WriteSlowPath(std::uint16_t address, std::uint8_t value) {
   switch (address >> 12) {
     // ROM and External RAM
     case 0x0 ... 0x7:
     case 0xA ... 0xB: {
-      if (mapper != nullptr)
+      if (mapper != nullptr) {
+        auto mapping_generation = mapper->mapping_generation;
         mapper->Write(address, value);
+        if (mapper->mapping_generation != mapping_generation) {
+          code_generation++;
+          UpdatePageTable();
+        }
+      }
       break;
     }
 
@@ -120,7 +176,10 @@ void Memory::WriteByte(std::uint16_t address, std::uint8_t value) {
       }
       // MMIO
       else if (address <= 0xFF7F || address == 0xFFFF) {
+        Synchronize();
         WriteMMIO(address & 0xFF, value);
+        // The write may have scheduled or canceled events.
+        cycles_until_event = scheduler->GetRemainingCycleCount();
       }
       // HRAM
       else
@@ -188,6 +247,8 @@ void Memory::WriteMMIO(std::uint8_t reg, std::uint8_t value) {
 
   if (reg == 0x50) {
     bootrom_disable = value & 1;
+    code_generation++;
+    UpdatePageTable();
     return;
   }
 
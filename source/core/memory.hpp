@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdio>
+
 #include "apu/apu.hpp"
 #include "cpu/memory.hpp"
 #include "irq.hpp"
@@ -15,15 +18,43 @@
 #include "joypad.hpp"
 #include "timer.hpp"
 
-class Memory : public MemoryBase {
+class Memory final : public MemoryBase {
 public:
   Memory(Scheduler* scheduler, IRQ* irq, PPU* ppu, APU* apu, Timer* timer, Joypad* joypad)
     : scheduler(scheduler), irq(irq), ppu(ppu), apu(apu), timer(timer), joypad(joypad) { Reset(); }
 
   void Reset();
+  void UpdatePageTable();
+
+  /// Catches up the scheduler and the APU with the CPU.
+  void Synchronize();
+
+  /// Advances time by whole M-cycles while the CPU is idle, stopping at the
+  /// first cycle on which an event is due or `timestamp` is reached.
+  void FastForward(std::uint64_t timestamp);
+
+  /// Skips whole iterations of an idle loop that take `cycles` each, as long
+  /// as they end before the next event is due or `timestamp` is reached.
+  void SkipIdleLoop(int cycles, std::uint64_t timestamp);
+
+  /// Current time as seen by the CPU, which may be ahead of the scheduler.
+  auto GetTimestampNow() const -> std::uint64_t override {
+    return scheduler->GetTimestampNow() + cycles_pending;
+  }
+
+  auto GetNextEventTimestamp() const -> std::uint64_t override {
+    return scheduler->GetTimestampTarget();
+  }
   auto ReadByte(std::uint16_t address) -> std::uint8_t override;
   void WriteByte(std::uint16_t address, std::uint8_t value) override;
   auto GetROM1Bank() -> std::uint8_t override { return mapper == nullptr ? 1 : mapper->GetROM1Bank(); }
+  void Tick() override;
+  auto GetCodeBank(std::uint16_t address) -> int override;
+  auto ReadCode(std::uint16_t address) -> std::uint8_t override { return mapper->Read(address); }
+
+  /// Reads memory without taking time. MMIO registers read as 0xFF, since
+  /// reading them may have side effects.
+  auto Peek(std::uint16_t address) -> std::uint8_t;
 
   /// BOOTROM memory region
   std::uint8_t boot[256];
@@ -32,6 +63,9 @@ public:
   MBCBase* mapper = nullptr;
 
 private:
+  /// The recompiler accesses the page tables and pending cycles directly.
+  template <typename Bus> friend class CPU;
+
   std::uint8_t rom[0x8000];
   std::uint8_t wram[0x2000];
   std::uint8_t hram[0x7F];
@@ -44,6 +78,17 @@ private:
 
   bool bootrom_disable;
 
+  /// Cycles the CPU has run ahead of the scheduler. Nothing observes the
+  /// skipped time until an event is due or a MMIO register is accessed.
+  int cycles_pending;
+  int cycles_until_event;
+
+  /// Host memory for each 256 byte page, nullptr for pages that need the slow path.
+  std::uint8_t const* read_page[256];
+  std::uint8_t* write_page[256];
+
+  auto ReadSlowPath(std::uint16_t address) -> std::uint8_t;
+  void WriteSlowPath(std::uint16_t address, std::uint8_t value);
   auto ReadMMIO(std::uint8_t reg) -> std::uint8_t;
   void WriteMMIO(std::uint8_t reg, std::uint8_t value);
 
@@ -54,3 +99,57 @@ private:
   static constexpr std::uint8_t kPPUMinReg = 0x40;
   static constexpr std::uint8_t kPPUMaxReg = 0x4B;
 };
+
+// Memory accesses are defined here so that they can be inlined into the CPU.
+
+inline void Memory::Tick() {
+  cycles_pending += 4;
+  if (cycles_pending >= cycles_until_event)
+    Synchronize();
+}
+
+inline void Memory::FastForward(std::uint64_t timestamp) {
+  auto cycles = std::min<std::int64_t>(cycles_until_event - cycles_pending, timestamp - GetTimestampNow());
+  auto ticks = std::max<std::int64_t>((cycles + 3) / 4, 1);
+  cycles_pending += int(ticks * 4);
+  if (cycles_pending >= cycles_until_event)
+    Synchronize();
+}
+
+inline void Memory::SkipIdleLoop(int cycles, std::uint64_t timestamp) {
+  auto limit = std::min<std::int64_t>(cycles_until_event - cycles_pending, timestamp - GetTimestampNow());
+  if (limit >= cycles) {
+    cycles_pending += int(limit / cycles * cycles);
+    if (cycles_pending >= cycles_until_event)
+      Synchronize();
+  }
+}
+
+inline auto Memory::ReadByte(std::uint16_t address) -> std::uint8_t {
+  Tick();
+
+  auto page = read_page[address >> 8];
+  if (page != nullptr)
+    return page[address & 0xFF];
+  return ReadSlowPath(address);
+}
+
+inline auto Memory::Peek(std::uint16_t address) -> std::uint8_t {
+  if (address >= 0xFF00 && (address <= 0xFF7F || address == 0xFFFF))
+    return 0xFF;
+
+  auto page = read_page[address >> 8];
+  if (page != nullptr)
+    return page[address & 0xFF];
+  return ReadSlowPath(address);
+}
+
+inline void Memory::WriteByte(std::uint16_t address, std::uint8_t value) {
+  Tick();
+
+  auto page = write_page[address >> 8];
+  if (page != nullptr)
+    page[address & 0xFF] = value;
+  else
+    WriteSlowPath(address, value);
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#if defined(REBOY_AVX2) && defined(__GNUC__) && defined(__x86_64__)
+#define REBOY_COMPOSE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "renderer.hpp"
+
+#ifdef REBOY_COMPOSE_AVX2
+
+/// The AVX2 path is built with a target attribute, so that the rest of the
+/// emulator runs on CPUs without AVX2. It is only taken after checking CPUID.
+static auto HasAVX2() -> bool {
+  static const bool has_avx2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }();
+  return has_avx2;
+}
+
+/// Resolves 8 ARGB8888 pixels at a time with permutevar8x32 and blends in
+/// the OBJ colors. `palette` is indexed like Renderer::palette.
+__attribute__((target("avx2")))
+static void ComposeARGB8888AVX2(std::uint32_t const* palette, std::uint8_t const* line_bg,
+                                std::uint8_t const* line_obj, std::uint32_t* output) {
+  auto palette_bg = _mm256_loadu_si256((__m256i const*)&palette[0]);
+  auto palette_obj = _mm256_loadu_si256((__m256i const*)&palette[8]);
+
+  for (int x = 0; x < 160; x += 8) {
+    auto bg_index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const*)&line_bg[x]));
+    auto obj_index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i const*)&line_obj[x]));
+    auto color_bg = _mm256_permutevar8x32_epi32(palette_bg, bg_index);
+    auto color_obj = _mm256_permutevar8x32_epi32(palette_obj, obj_index);
+    auto has_obj = _mm256_cmpgt_epi32(obj_index, _mm256_setzero_si256());
+    _mm256_storeu_si256((__m256i*)&output[x], _mm256_blendv_epi8(color_bg, color_obj, has_obj));
+  }
+}
+
+#endif
+
+/// Merges line_bg and line_obj into one palette key per pixel:
+/// the BG palette index (0 - 3), or OBJ pixel | 8 (8 - 15) where an OBJ is visible.
+/// OBJ pixels in line_obj already passed the priority check.
+void Renderer::ComposeKeys(std::uint8_t* keys) {
+  int x = 0;
+
+#if defined(__SSE2__)
+  for (; x < 160; x += 16) {
+    auto bg_index = _mm_loadu_si128((__m128i const*)&line_bg[x]);
+    auto obj_index = _mm_loadu_si128((__m128i const*)&line_obj[x]);
+    auto no_obj = _mm_cmpeq_epi8(obj_index, _mm_setzero_si128());
+    auto key = _mm_or_si128(_mm_and_si128(no_obj, bg_index),
+                            _mm_andnot_si128(no_obj, _mm_or_si128(obj_index, _mm_set1_epi8(8))));
+    _mm_storeu_si128((__m128i*)&keys[x], key);
+  }
+#endif
+
+  for (; x < 160; x++) {
+    auto obj = line_obj[x];
+    keys[x] = obj != 0 ? (8 | obj) : line_bg[x];
+  }
+}
+
+/// Resolves the palette indices of the current scanline into pixels of the
+/// output format.
+template <PixelFormat format>
+void Renderer::ComposeScanline(Scanline const& line) {
+#ifdef REBOY_COMPOSE_AVX2
+  if (format == PixelFormat::ARGB8888 && HasAVX2()) {
+    ComposeARGB8888AVX2(palette, line_bg, line_obj, (std::uint32_t*)line.buffer + 160 * line.ly);
+    return;
+  }
+#endif
+
+  std::uint8_t keys[160];
+
+  ComposeKeys(keys);
+
+  switch (format) {
+    case PixelFormat::ARGB8888: {
+      auto output = (std::uint32_t*)line.buffer + 160 * line.ly;
+      for (int x = 0; x < 160; x++) {
+        output[x] = palette[keys[x]];
+      }
+      break;
+    }
+    case PixelFormat::RGB565: {
+      static constexpr std::uint16_t kColorsRGB565[4] {
+        0xFFFF, 0x630C, 0x2104, 0x0000 };
+      auto output = (std::uint16_t*)line.buffer + 160 * line.ly;
+      for (int x = 0; x < 160; x++) {
+        output[x] = kColorsRGB565[shades[keys[x]]];
+      }
+      break;
+    }
+    case PixelFormat::Gray8: {
+      static constexpr std::uint8_t kColorsGray8[4] {
+        0xFF, 0x60, 0x20, 0x00 };
+      auto output = (std::uint8_t*)line.buffer + 160 * line.ly;
+      for (int x = 0; x < 160; x++) {
+        output[x] = kColorsGray8[shades[keys[x]]];
+      }
+      break;
+    }
+    case PixelFormat::Shade2: {
+      auto output = (std::uint8_t*)line.buffer + 40 * line.ly;
+      for (int x = 0; x < 160; x += 4) {
+        output[x >> 2] = shades[keys[x + 0]] |
+                        (shades[keys[x + 1]] << 2) |
+                        (shades[keys[x + 2]] << 4) |
+                        (shades[keys[x + 3]] << 6);
+      }
+      break;
+    }
+  }
+}
+
+template void Renderer::ComposeScanline<PixelFormat::ARGB8888>(Scanline const& line);
+template void Renderer::ComposeScanline<PixelFormat::RGB565>(Scanline const& line);
+template void Renderer::ComposeScanline<PixelFormat::Gray8>(Scanline const& line);
+template void Renderer::ComposeScanline<PixelFormat::Shade2>(Scanline const& line);
@@ -5,20 +5,27 @@
  * Refer to the included LICENSE file.
  */
 
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
 
 #include "ppu.hpp"
 
-constexpr std::uint32_t PPU::kColorPalette[4];
-
 PPU::PPU(Scheduler* scheduler, IRQ* irq) : scheduler(scheduler), irq(irq)  {
+  scheduler->Register<PPU, &PPU::OnModeEnd>(&mode_event, this);
   Reset();
 }
 
 void PPU::Reset() {
   std::memset(vram, 0, 0x2000);
   std::memset(oam, 0, 0xA0);
+  for (auto& sprite : objs) {
+    sprite = {};
+  }
+  if (render_worker.IsRunning()) {
+    render_worker.Flush();
+  }
+  renderer.Reset();
   lcdc = {};
   stat = {};
   scy = 0;
@@ -28,188 +35,218 @@ void PPU::Reset() {
   obp[1] = 0;
   ly = 0;
   lyc = 0;
+  frame_count = 0;
+  MarkAllLinesDirty();
+  frame_unchanged = false;
+  BeginFrame();
   hblank_irq_flag_old = false;
   vblank_irq_flag_old = false;
   vcount_irq_flag_old = false;
   stat.mode = Mode::Search;
   Schedule(Mode::Transfer, 0);
-  oam_is_dirty = true;
+  for (auto& dirty : obj_line_is_dirty) {
+    dirty = true;
+  }
   SearchAndPrioritizeOBJs();
 }
 
+void PPU::BeginFrame() {
+  frame_changed = false;
+  render_frame = frame_count >= frame_skip.until &&
+                 (frame_skip.period <= 0 || int(frame_count % frame_skip.period) >= frame_skip.skip);
+}
+
 void PPU::RenderScanline() {
-  if (buffer == nullptr)
+  if (buffer == nullptr || !render_frame)
     return;
 
-  for (int x = 0; x < 160; x++)
-    bg_is_color0[x] = true;
-
-  if (lcdc.enable_bg)
-    RenderBackground();
-
-  if (lcdc.enable_win && ly >= wy)
-    RenderWindow();
+  // OAM may have changed since the OBJ search at the start of the scanline,
+  // so that the list could name OBJs which do not cover it anymore.
+  SearchAndPrioritizeOBJs();
 
-  if (lcdc.enable_obj)
-    RenderSprites();
-}
+  if (IsScanlineUpToDate())
+    return;
 
-void PPU::RenderBackground() {
-  auto line = &buffer[160 * ly];
+  auto& inputs = line_inputs[ly];
+  inputs.is_dirty = false;
+  inputs.generation = vram_generation;
+  inputs.lcdc = ReadMMIO(REG_LCDC);
+  inputs.scy = scy;
+  inputs.scx = scx;
+  inputs.wy = wy;
+  inputs.wx = wx;
+  inputs.bgp = bgp;
+  inputs.obp[0] = obp[0];
+  inputs.obp[1] = obp[1];
+  frame_changed = true;
+
+  Renderer::Scanline line;
+  auto const& sorted = sorted_objs[ly];
 
-  auto map_y = (ly + scy) & 0xFF;
-  auto block_x = scx >> 3;
-  auto block_y = map_y >> 3;
-  auto tile_y = map_y & 7;
-  auto map_data = &vram[0x1800 + 0x400 * lcdc.bg_map_select + block_y * 32];
+  line.buffer = buffer;
+  line.format = buffer_format;
+  line.lcdc = lcdc;
+  line.ly = ly;
+  line.scy = scy;
+  line.scx = scx;
+  line.wy = wy;
+  line.wx = wx;
+  line.bgp = bgp;
+  line.obp[0] = obp[0];
+  line.obp[1] = obp[1];
+  line.obj_count = sorted.count;
+  for (int i = 0; i < sorted.count; i++) {
+    line.objs[i] = *sorted.list[i];
+  }
 
-  auto screen_x = -(scx & 7);
+  if (render_worker.IsRunning()) {
+    render_worker.Render(line);
+  } else {
+    renderer.Render(line);
+  }
+}
 
-  while (screen_x < 160) {
-    auto index = 0;
-    auto tile = map_data[block_x];
-    std::uint8_t byte0, byte1;
+auto PPU::IsScanlineUpToDate() -> bool {
+  auto const& inputs = line_inputs[ly];
+
+  if (inputs.is_dirty ||
+      inputs.lcdc != ReadMMIO(REG_LCDC) ||
+      inputs.scy != scy ||
+      inputs.scx != scx ||
+      inputs.wy != wy ||
+      inputs.wx != wx ||
+      inputs.bgp != bgp ||
+      inputs.obp[0] != obp[0] ||
+      inputs.obp[1] != obp[1]) {
+    return false;
+  }
 
-    if (lcdc.bg_win_tile_select == 1) {
-      index = tile << 4 | tile_y << 1;
-    } else {
-      index = 0x1000 + std::int8_t(tile) * 16 + tile_y * 2;
+  // Check the map rows and tiles that the renderer reads for this scanline.
+  if (lcdc.enable_bg) {
+    auto first_x = scx >> 3;
+    if (!IsMapRowUpToDate(lcdc.bg_map_select, (ly + scy) & 0xFF, first_x, first_x + 20)) {
+      return false;
     }
+  }
 
-    byte0 = vram[index | 0];
-    byte1 = vram[index | 1];
+  if (lcdc.enable_bg && lcdc.enable_win && ly >= wy && wx < 167) {
+    if (!IsMapRowUpToDate(lcdc.win_map_select, ly - wy, 0, (166 - wx) >> 3)) {
+      return false;
+    }
+  }
 
-    for (int tile_x = 0; tile_x < 8; tile_x++) {
-      auto palette_index = (byte0 >> 7) | ((byte1 >> 7) << 1);
-      byte0 <<= 1;
-      byte1 <<= 1;
-      if (screen_x >= 0 && screen_x < 160) {
-        line[screen_x] = kColorPalette[(bgp >> (palette_index * 2)) & 3];
-        bg_is_color0[screen_x] = palette_index == 0;
+  if (lcdc.enable_obj) {
+    auto const& sorted = sorted_objs[ly];
+    for (int i = 0; i < sorted.count; i++) {
+      auto tile = sorted.list[i]->tile;
+      if (lcdc.obj_double_size) {
+        tile &= ~1;
+        if (tile_generation[tile | 1] > inputs.generation) {
+          return false;
+        }
+      }
+      if (tile_generation[tile] > inputs.generation) {
+        return false;
       }
-      screen_x++;
     }
-
-    block_x = (block_x + 1) & 0x1F;
   }
-}
 
-void PPU::RenderWindow() {
-  auto line = &buffer[160 * ly];
-
-  auto map_y = ly - wy;
-  auto tile_y = map_y & 7;
-  auto block_y = map_y >> 3;
-  auto map_data = &vram[0x1800 + 0x400 * lcdc.win_map_select + block_y * 32];
+  return true;
+}
 
-  auto screen_x = wx - 7;
-  auto block_x = 0;
+auto PPU::IsMapRowUpToDate(int map_select, int y, int first_x, int last_x) -> bool {
+  auto generation = line_inputs[ly].generation;
+  auto block_y = y >> 3;
 
-  while (screen_x < 160) {
-    auto index = 0;
-    auto tile = map_data[block_x++];
-    std::uint8_t byte0, byte1;
+  if (map_row_generation[map_select][block_y] > generation) {
+    return false;
+  }
 
-    if (lcdc.bg_win_tile_select == 1) {
-      index = tile << 4 | tile_y << 1;
-    } else {
-      index = 0x1000 + std::int8_t(tile) * 16 + tile_y * 2;
+  // Map entries select tiles 0 - 255 or, with signed numbers, 128 - 383.
+  auto map = &vram[0x1800 + 0x400 * map_select + block_y * 32];
+  for (int block_x = first_x; block_x <= last_x; block_x++) {
+    int tile = map[block_x & 31];
+    if (lcdc.bg_win_tile_select == 0) {
+      tile = 256 + std::int8_t(tile);
+    }
+    if (tile_generation[tile] > generation) {
+      return false;
     }
+  }
+  return true;
+}
 
-    byte0 = vram[index | 0];
-    byte1 = vram[index | 1];
+void PPU::SetThreadedRendering(bool enable) {
+  if (enable && !render_worker.IsRunning()) {
+    render_worker.Start();
+  } else if (!enable && render_worker.IsRunning()) {
+    render_worker.Stop();
+  }
+}
 
-    for (int tile_x = 0; tile_x < 8; tile_x++) {
-      auto palette_index = (byte0 >> 7) | ((byte1 >> 7) << 1);
-      byte0 <<= 1;
-      byte1 <<= 1;
-      if (screen_x >= 0 && screen_x < 160) {
-        line[screen_x] = kColorPalette[(bgp >> (palette_index * 2)) & 3];
-        bg_is_color0[screen_x] = palette_index == 0;
-      }
-      screen_x++;
-    }
+void PPU::ReleaseFrames() {
+  if (render_worker.IsRunning()) {
+    render_worker.Release();
   }
 }
 
-void PPU::RenderSprites() {
-  auto line = &buffer[160 * ly];
+void PPU::WaitForFrames() {
+  if (render_worker.IsRunning()) {
+    frame_unchanged = !render_worker.Wait();
+  }
+}
 
-  auto const& sorted = sorted_objs[ly];
+void PPU::MarkAllLinesDirty() {
+  for (auto& inputs : line_inputs) {
+    inputs.is_dirty = true;
+  }
+}
 
-  for (int i = sorted.count - 1; i >= 0; i--) {
-    auto sprite = sorted.list[i];
-    auto x = int(sprite->x) - 8;
-    auto y = int(sprite->y) - 16;
-    auto tile = sprite->tile;
-    auto tile_y = ly - y;
-    if (sprite->flip_y) {
-      tile_y ^= lcdc.obj_double_size ? 15 : 7;
-    }
-    if (lcdc.obj_double_size) {
-      tile = (tile & ~1) | (tile_y >> 3);
-      tile_y &= 7;
-    }
-    auto index = (tile << 4) | (tile_y << 1);
-    auto byte0 = vram[index | 0];
-    auto byte1 = vram[index | 1];
-    auto x_xor = sprite->flip_x ? 7 : 0;
-    auto pal = obp[sprite->palette];
-    for (int tile_x = 0; tile_x < 8; tile_x++) {
-      auto palette_index = (byte0 >> 7) | ((byte1 >> 7) << 1);
-      byte0 <<= 1;
-      byte1 <<= 1;
-      if (palette_index == 0) {
-        continue;
-      }
-      auto screen_x = x + (tile_x ^ x_xor);
-      if (screen_x >= 0 && screen_x < 160 && (!sprite->behind_bg || bg_is_color0[screen_x])) {
-        line[screen_x] = kColorPalette[(pal >> (palette_index * 2)) & 3];
-      }
-    }
+void PPU::MarkOBJLinesDirty(int y) {
+  // Mark the lines covered by a 8x16 OBJ, which includes those of a 8x8 OBJ.
+  // Both their OBJ list and their pixels need to be updated.
+  auto first = std::max(y - 16, 0);
+  auto last = std::min(y, 144);
+  for (int line = first; line < last; line++) {
+    obj_line_is_dirty[line] = true;
+    line_inputs[line].is_dirty = true;
   }
 }
 
 void PPU::SearchAndPrioritizeOBJs() {
-  if (!oam_is_dirty) {
+  if (!obj_line_is_dirty[ly]) {
     return;
   }
 
-  oam_is_dirty = false;
+  // The scanline may have been drawn from the old list after OAM changed.
+  obj_line_is_dirty[ly] = false;
+  line_inputs[ly].is_dirty = true;
 
   auto height = lcdc.obj_double_size ? 16 : 8;
+  auto& sorted = sorted_objs[ly];
 
-  for (int line = 0; line < 144; line++) {
-    for (auto& bucket : buckets) {
-      bucket = {};
-    }
+  sorted.count = 0;
 
-    for (auto const& sprite : objs) {
-      auto y = int(sprite.y) - 16;
-      if (line < y || line >= (y + height)) {
-        continue;
-      }
-      auto& bucket = buckets[sprite.x];
-      if (bucket.count == 10) {
-        continue;
-      }
-      bucket.list[bucket.count++] = &sprite;
+  // Keep the 10 OBJs with the lowest X coordinate, OBJs earlier in OAM first.
+  for (auto const& sprite : objs) {
+    auto y = int(sprite.y) - 16;
+    if (ly < y || ly >= (y + height)) {
+      continue;
     }
-
-    // Collect at maximum 10 sprites from the buckets.
-    int i = 0;
-    int j = 0;
-    auto& sorted = sorted_objs[line];
-    sorted = {};
-    while (sorted.count < 10 && i < 256) {
-      auto const& bucket = buckets[i];
-      if (j == bucket.count) {
-        i++;
-        j = 0;
-        continue;
-      }
-      sorted.list[sorted.count++] = bucket.list[j++];
+    auto i = sorted.count;
+    while (i > 0 && sorted.list[i - 1]->x > sprite.x) {
+      i--;
     }
+    if (i == 10) {
+      continue;
+    }
+    if (sorted.count < 10) {
+      sorted.count++;
+    }
+    for (int j = sorted.count - 1; j > i; j--) {
+      sorted.list[j] = sorted.list[j - 1];
+    }
+    sorted.list[i] = &sprite;
   }
 }
 
@@ -231,46 +268,69 @@ void PPU::CheckSTATInterrupt() {
 }
 
 void PPU::Schedule(Mode mode, int cycles_late) {
+  static constexpr int kModeCycles[4] {
+    204, 456, 80, 172 };
   stat.mode = mode;
   CheckSTATInterrupt();
-  switch (mode) {
+  scheduler->Add(&mode_event, kModeCycles[static_cast<int>(mode)] - cycles_late);
+}
+
+void PPU::OnModeEnd(int cycles_late) {
+  switch (stat.mode) {
     case Mode::HBlank:
-      scheduler->Add(204 - cycles_late, [this](int cycles_late) {
-        if (++ly == 144) {
-          Schedule(Mode::VBlank, cycles_late);
-          irq->Raise(IRQ::VBLANK);
+      if (++ly == 144) {
+        if (render_worker.IsRunning()) {
+          render_worker.Submit();
         } else {
-          Schedule(Mode::Search, cycles_late);
-          SearchAndPrioritizeOBJs();
+          frame_unchanged = !frame_changed;
         }
-      });
+        Schedule(Mode::VBlank, cycles_late);
+        irq->Raise(IRQ::VBLANK);
+      } else {
+        Schedule(Mode::Search, cycles_late);
+        SearchAndPrioritizeOBJs();
+      }
       break;
     case Mode::VBlank:
-      scheduler->Add(456 - cycles_late, [this](int cycles_late) {
-        if (++ly == 154) {
-          ly = 0;
-          Schedule(Mode::Search, cycles_late);
-          SearchAndPrioritizeOBJs();
-        } else {
-          Schedule(Mode::VBlank, cycles_late);
-        }
-      });
+      if (++ly == 154) {
+        ly = 0;
+        frame_count++;
+        BeginFrame();
+        Schedule(Mode::Search, cycles_late);
+        SearchAndPrioritizeOBJs();
+      } else {
+        Schedule(Mode::VBlank, cycles_late);
+      }
       break;
     case Mode::Search:
-      scheduler->Add(80 - cycles_late, [this](int cycles_late) {
-        Schedule(Mode::Transfer, cycles_late);
-      });
+      Schedule(Mode::Transfer, cycles_late);
       break;
     case Mode::Transfer:
-      scheduler->Add(172 - cycles_late, [this](int cycles_late) {
-        // Drawing scanline at the end of the "transfer" period.
-        RenderScanline();
-        Schedule(Mode::HBlank, cycles_late);
-      });
+      // Drawing scanline at the end of the "transfer" period.
+      RenderScanline();
+      Schedule(Mode::HBlank, cycles_late);
       break;
   }
 }
 
+auto PPU::GetNextVBlankTimestamp() const -> std::uint64_t {
+  // Time at which the current scanline ends.
+  auto line_end = mode_event.GetTimestamp();
+  switch (stat.mode) {
+    case Mode::Search:
+      line_end += 172 + 204;
+      break;
+    case Mode::Transfer:
+      line_end += 204;
+      break;
+    case Mode::VBlank:
+      return line_end + (153 - ly + 144) * 456;
+    default:
+      break;
+  }
+  return line_end + (143 - ly) * 456;
+}
+
 auto PPU::ReadMMIO(std::uint8_t reg) -> std::uint8_t {
   switch (reg) {
     case REG_LCDC:
@@ -316,6 +376,11 @@ auto PPU::ReadMMIO(std::uint8_t reg) -> std::uint8_t {
 void PPU::WriteMMIO(std::uint8_t reg, std::uint8_t value) {
   switch (reg) {
     case REG_LCDC:
+      if (lcdc.obj_double_size != bool(value & 4)) {
+        for (auto& dirty : obj_line_is_dirty) {
+          dirty = true;
+        }
+      }
       lcdc.enable_bg = value & 1;
       lcdc.enable_obj = value & 2;
       lcdc.obj_double_size = value & 4;
@@ -11,6 +11,8 @@
 
 #include "../irq.hpp"
 #include "../scheduler.hpp"
+#include "renderer.hpp"
+#include "render_worker.hpp"
 
 class PPU {
 public:
@@ -18,16 +20,70 @@ public:
 
   void Reset();
 
-  void SetBuffer(std::uint32_t* buffer) {
+  void SetBuffer(void* buffer, PixelFormat format) {
+    if (this->buffer != buffer || buffer_format != format) {
+      MarkAllLinesDirty();
+    }
     this->buffer = buffer;
+    buffer_format = format;
   }
 
+  /// True if the last completed frame left the frame buffer untouched,
+  /// because no scanline needed to be drawn again. With threaded rendering
+  /// this refers to the frames released before the last WaitForFrames().
+  auto IsFrameUnchanged() const -> bool { return frame_unchanged; }
+
+  /// Draws scanlines on a worker thread instead of during emulation.
+  /// The frame buffer then lags one run of the emulator behind.
+  void SetThreadedRendering(bool enable);
+
+  /// Lets the render thread draw the frames completed so far.
+  void ReleaseFrames();
+
+  /// Waits until the render thread finished all released frames,
+  /// so that the frame buffer can be read.
+  void WaitForFrames();
+
+  /// Skips rendering of the first `skip` out of every `period` frames.
+  /// The PPU keeps its timing, interrupts and OAM search on skipped frames.
+  void SetFrameSkip(int skip, int period) {
+    frame_skip.skip = skip;
+    frame_skip.period = period;
+  }
+
+  /// Skips rendering of all frames before frame number `frame`.
+  void SkipFramesUntil(std::uint64_t frame) {
+    frame_skip.until = frame;
+  }
+
+  /// Number of the current frame, counting from zero at reset.
+  auto GetFrameCount() const -> std::uint64_t { return frame_count; }
+
+  /// Time at which the PPU enters VBlank next.
+  auto GetNextVBlankTimestamp() const -> std::uint64_t;
+
   auto ReadVRAM(std::uint16_t offset) -> std::uint8_t {
     return vram[offset];
   }
 
   void WriteVRAM(std::uint16_t offset, std::uint8_t value) {
+    if (vram[offset] == value) {
+      return;
+    }
+
     vram[offset] = value;
+    vram_generation++;
+    if (offset < 0x1800) {
+      tile_generation[offset >> 4] = vram_generation;
+    } else {
+      map_row_generation[(offset >> 10) & 1][(offset >> 5) & 31] = vram_generation;
+    }
+
+    if (render_worker.IsRunning()) {
+      render_worker.WriteVRAM(offset, value);
+    } else {
+      renderer.WriteVRAM(offset, value);
+    }
   }
 
   auto ReadOAM(std::uint8_t offset) -> std::uint8_t {
@@ -35,19 +91,21 @@ public:
   }
 
   void WriteOAM(std::uint8_t offset, std::uint8_t value) {
+    if (oam[offset] == value) {
+      return;
+    }
+
     oam[offset] = value;
 
     // Decode sprite data into our convenient structure.
     auto& sprite = objs[offset >> 2];
+    MarkOBJLinesDirty(sprite.y);
     switch (offset & 3) {
       case 0:
-        if (sprite.y != value)
-          oam_is_dirty = true;
+        MarkOBJLinesDirty(value);
         sprite.y = value;
         break;
       case 1:
-        if (sprite.x != value)
-          oam_is_dirty = true;
         sprite.x = value;
         break;
       case 2:
@@ -90,16 +148,7 @@ private:
   std::uint8_t vram[0x2000];
   std::uint8_t oam[0xA0];
 
-  struct LCDC {
-    bool enable_bg = false;
-    bool enable_obj = false;
-    bool obj_double_size = false;
-    int bg_map_select = 0;
-    int bg_win_tile_select = 0;
-    bool enable_win = false;
-    int win_map_select = 0;
-    bool enable_display = false;
-  } lcdc;
+  Renderer::LCDC lcdc;
 
   struct STAT {
     Mode mode = Mode::Search;
@@ -119,50 +168,76 @@ private:
   std::uint8_t wy;
   std::uint8_t wx;
 
-  bool bg_is_color0[160];
-
-  /// Indicates that OBJs changed and need to be sorted again.
-  bool oam_is_dirty;
+  /// Indicates for each scanline that OBJs covering it changed and
+  /// the scanline's OBJ list needs to be built again.
+  bool obj_line_is_dirty[144];
 
   /// List of all current OBJs with pre-decoded information.
-  struct OAM {
-    std::uint8_t x;
-    std::uint8_t y;
-    std::uint8_t tile;
-    int palette;
-    bool flip_x;
-    bool flip_y;
-    bool behind_bg;
-  } objs[40];
-
-  /// Buckets for bucketsort, used to prioritze OBJs.
-  struct OAMSearchBucket {
-    int count = 0;
-    OAM const* list[10];
-  } buckets[256];
+  Renderer::OAM objs[40];
 
   /// List up to 10 OBJs which will be rendered for each scanline.
   /// Sorted by priority in ascending order.
   struct OAMSortedList {
     int count = {};
-    OAM const* list[10];
+    Renderer::OAM const* list[10];
   } sorted_objs[144];
 
   Scheduler* scheduler;
+  Scheduler::Event mode_event;
   IRQ* irq;
   bool hblank_irq_flag_old;
   bool vblank_irq_flag_old;
   bool vcount_irq_flag_old;
-  std::uint32_t* buffer;
-
+  void* buffer = nullptr;
+  PixelFormat buffer_format = PixelFormat::ARGB8888;
+
+  struct FrameSkip {
+    int skip = 0;
+    int period = 0;
+    std::uint64_t until = 0;
+  } frame_skip;
+
+  std::uint64_t frame_count;
+
+  /// Incremented on every VRAM write that changes a byte. Each tile and
+  /// each row of both tile maps remembers the generation of its last write.
+  std::uint64_t vram_generation = 0;
+  std::uint64_t tile_generation[384] {};
+  std::uint64_t map_row_generation[2][32] {};
+
+  /// What each scanline was last drawn from. A scanline is only drawn again
+  /// if one of its registers changed, if tile data or a map row it shows was
+  /// written since, or if it is dirty because its OBJs or the frame buffer
+  /// changed.
+  struct LineInputs {
+    bool is_dirty = true;
+    std::uint64_t generation = 0;
+    std::uint8_t lcdc = 0;
+    std::uint8_t scy = 0;
+    std::uint8_t scx = 0;
+    std::uint8_t wy = 0;
+    std::uint8_t wx = 0;
+    std::uint8_t bgp = 0;
+    std::uint8_t obp[2] {};
+  } line_inputs[144];
+
+  bool frame_changed;
+  bool frame_unchanged;
+
+  /// Whether the current frame is rendered, decided at the start of the frame.
+  bool render_frame;
+
+  Renderer renderer;
+  RenderWorker render_worker {&renderer};
+
+  void BeginFrame();
   void RenderScanline();
-  void RenderBackground();
-  void RenderWindow();
-  void RenderSprites();
+  auto IsScanlineUpToDate() -> bool;
+  auto IsMapRowUpToDate(int map_select, int y, int first_x, int last_x) -> bool;
+  void MarkAllLinesDirty();
+  void MarkOBJLinesDirty(int y);
   void SearchAndPrioritizeOBJs();
   void CheckSTATInterrupt();
   void Schedule(Mode mode, int cycles_late);
-
-  static constexpr std::uint32_t kColorPalette[4] = {
-    0xFFFFFFFF, 0xFF606060, 0xFF202020, 0xFF000000 };
+  void OnModeEnd(int cycles_late);
 };
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include "render_worker.hpp"
+
+RenderWorker::~RenderWorker() {
+  if (running) {
+    Stop();
+  }
+}
+
+void RenderWorker::Start() {
+  recording = AllocateFrame();
+  stop = false;
+  running = true;
+  thread = std::thread{&RenderWorker::Run, this};
+}
+
+void RenderWorker::Stop() {
+  Flush();
+  {
+    std::lock_guard guard{mutex};
+    stop = true;
+  }
+  work_available.notify_one();
+  thread.join();
+  running = false;
+}
+
+void RenderWorker::Flush() {
+  Submit();
+  Release();
+  Wait();
+}
+
+void RenderWorker::Submit() {
+  auto frame = AllocateFrame();
+  std::swap(frame, recording);
+  {
+    std::lock_guard guard{mutex};
+    queue.push_back(std::move(frame));
+    submitted++;
+  }
+}
+
+void RenderWorker::Release() {
+  {
+    std::lock_guard guard{mutex};
+    if (released == submitted) {
+      return;
+    }
+    released = submitted;
+  }
+  work_available.notify_one();
+}
+
+auto RenderWorker::Wait() -> bool {
+  std::unique_lock lock{mutex};
+  work_done.wait(lock, [this]() { return completed == released; });
+  auto result = changed;
+  changed = false;
+  return result;
+}
+
+void RenderWorker::Run() {
+  std::unique_lock lock{mutex};
+
+  for (;;) {
+    work_available.wait(lock, [this]() { return stop || completed != released; });
+    if (completed == released) {
+      return;
+    }
+
+    auto frame = std::move(queue.front());
+    queue.pop_front();
+    lock.unlock();
+
+    Replay(*frame);
+    auto drew_lines = !frame->lines.empty();
+    frame->vram_writes.clear();
+    frame->lines.clear();
+
+    lock.lock();
+    changed = changed || drew_lines;
+    free_frames.push_back(std::move(frame));
+    if (++completed == released) {
+      work_done.notify_one();
+    }
+  }
+}
+
+void RenderWorker::Replay(Frame const& frame) {
+  std::size_t i = 0;
+
+  for (auto const& line : frame.lines) {
+    for (; i < line.vram_write_count; i++) {
+      renderer->WriteVRAM(frame.vram_writes[i].offset, frame.vram_writes[i].value);
+    }
+    renderer->Render(line.scanline);
+  }
+
+  for (; i < frame.vram_writes.size(); i++) {
+    renderer->WriteVRAM(frame.vram_writes[i].offset, frame.vram_writes[i].value);
+  }
+}
+
+auto RenderWorker::AllocateFrame() -> std::unique_ptr<Frame> {
+  std::lock_guard guard{mutex};
+  if (free_frames.empty()) {
+    return std::make_unique<Frame>();
+  }
+  auto frame = std::move(free_frames.back());
+  free_frames.pop_back();
+  return frame;
+}
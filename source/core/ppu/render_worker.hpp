@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "renderer.hpp"
+
+/// Records the scanlines and VRAM writes of each frame and replays them
+/// through a Renderer on a worker thread.
+///
+/// Frames are drawn with a delay of one run of the emulator: frames submitted
+/// during a run are released at the start of the next run and are finished
+/// by its end. The frame buffer is left alone while the emulator is not running.
+class RenderWorker {
+public:
+  RenderWorker(Renderer* renderer) : renderer(renderer) {}
+ ~RenderWorker();
+
+  auto IsRunning() const -> bool { return running; }
+
+  void Start();
+
+  /// Draws all recorded frames and stops the worker thread.
+  void Stop();
+
+  /// Draws all recorded frames and waits for them.
+  void Flush();
+
+  void WriteVRAM(std::uint16_t offset, std::uint8_t value) {
+    recording->vram_writes.push_back({offset, value});
+  }
+
+  void Render(Renderer::Scanline const& line) {
+    recording->lines.push_back({line, recording->vram_writes.size()});
+  }
+
+  /// Hands the recorded frame over to the worker thread.
+  void Submit();
+
+  /// Lets the worker thread draw all frames submitted so far.
+  void Release();
+
+  /// Waits until all released frames are drawn.
+  /// Returns true if any of them touched the frame buffer.
+  auto Wait() -> bool;
+
+private:
+  struct VRAMWrite {
+    std::uint16_t offset;
+    std::uint8_t value;
+  };
+
+  struct Line {
+    Renderer::Scanline scanline;
+    /// Number of VRAM writes to apply before drawing the line.
+    std::size_t vram_write_count;
+  };
+
+  struct Frame {
+    std::vector<VRAMWrite> vram_writes;
+    std::vector<Line> lines;
+  };
+
+  void Run();
+  void Replay(Frame const& frame);
+  auto AllocateFrame() -> std::unique_ptr<Frame>;
+
+  Renderer* renderer;
+  bool running = false;
+  std::thread thread;
+
+  std::unique_ptr<Frame> recording;
+
+  std::mutex mutex;
+  std::condition_variable work_available;
+  std::condition_variable work_done;
+  std::deque<std::unique_ptr<Frame>> queue;
+  std::vector<std::unique_ptr<Frame>> free_frames;
+  std::uint64_t submitted = 0;
+  std::uint64_t released = 0;
+  std::uint64_t completed = 0;
+  bool changed = false;
+  bool stop = false;
+};
@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "renderer.hpp"
+
+constexpr std::uint32_t Renderer::kColorPalette[4];
+
+void Renderer::Reset() {
+  std::memset(vram, 0, 0x2000);
+  std::memset(tile_cache, 0, sizeof(tile_cache));
+  for (auto& layer : layers) {
+    std::memset(layer.pixels, 0, sizeof(layer.pixels));
+    layer.tile_select = 0;
+    MarkLayerDirty(layer);
+  }
+  for (auto& dirty : tile_is_dirty) {
+    dirty = false;
+  }
+  any_tile_is_dirty = false;
+  bgp = 0;
+  obp[0] = 0;
+  obp[1] = 0;
+  for (int i = 0; i < 16; i++) {
+    shades[i] = 0;
+    palette[i] = 0;
+  }
+  UpdatePalette(0, bgp);
+  UpdatePalette(8, obp[0]);
+  UpdatePalette(12, obp[1]);
+}
+
+void Renderer::WriteVRAM(std::uint16_t offset, std::uint8_t value) {
+  vram[offset] = value;
+
+  // Decode the touched row of tile data.
+  if (offset < 0x1800) {
+    auto row = tile_cache[offset >> 4][(offset >> 1) & 7];
+    auto byte0 = vram[offset & ~1];
+    auto byte1 = vram[offset |  1];
+    for (int x = 0; x < 8; x++) {
+      row[x] = ((byte0 >> (7 - x)) & 1) | (((byte1 >> (7 - x)) & 1) << 1);
+    }
+    tile_is_dirty[offset >> 4] = true;
+    any_tile_is_dirty = true;
+  } else {
+    auto& layer = layers[(offset >> 10) & 1];
+    auto block_x = offset & 31;
+    auto block_y = (offset >> 5) & 31;
+    layer.entry_is_dirty[block_y][block_x] = true;
+    layer.row_is_dirty[block_y] = true;
+  }
+}
+
+void Renderer::Render(Scanline const& line) {
+  // A disabled BG is blank white on DMG, whatever BGP holds.
+  auto line_bgp = line.lcdc.enable_bg ? line.bgp : std::uint8_t(0);
+  if (line_bgp != bgp) {
+    bgp = line_bgp;
+    UpdatePalette(0, bgp);
+  }
+
+  for (int i = 0; i < 2; i++) {
+    if (line.obp[i] != obp[i]) {
+      obp[i] = line.obp[i];
+      UpdatePalette(8 + i * 4, obp[i]);
+    }
+  }
+
+  if (line.lcdc.enable_bg) {
+    RenderBackground(line);
+  } else {
+    std::memset(line_bg, 0, sizeof(line_bg));
+  }
+
+  // The window is disabled along with the BG.
+  if (line.lcdc.enable_bg && line.lcdc.enable_win && line.ly >= line.wy)
+    RenderWindow(line);
+
+  std::memset(line_obj, 0, sizeof(line_obj));
+  if (line.lcdc.enable_obj)
+    RenderSprites(line);
+
+  switch (line.format) {
+    case PixelFormat::ARGB8888:
+      ComposeScanline<PixelFormat::ARGB8888>(line);
+      break;
+    case PixelFormat::RGB565:
+      ComposeScanline<PixelFormat::RGB565>(line);
+      break;
+    case PixelFormat::Gray8:
+      ComposeScanline<PixelFormat::Gray8>(line);
+      break;
+    case PixelFormat::Shade2:
+      ComposeScanline<PixelFormat::Shade2>(line);
+      break;
+  }
+}
+
+auto Renderer::GetBGTileNumber(int tile_select, std::uint8_t tile) -> int {
+  if (tile_select == 1) {
+    return tile;
+  }
+  return 256 + std::int8_t(tile);
+}
+
+void Renderer::MarkLayerDirty(Layer& layer) {
+  for (int block_y = 0; block_y < 32; block_y++) {
+    for (int block_x = 0; block_x < 32; block_x++) {
+      layer.entry_is_dirty[block_y][block_x] = true;
+    }
+    layer.row_is_dirty[block_y] = true;
+  }
+}
+
+void Renderer::UpdateDirtyTiles() {
+  if (!any_tile_is_dirty) {
+    return;
+  }
+
+  // Tile data is usually written in bulk, so find the map entries using
+  // the changed tiles once, right before the layers are needed.
+  for (int i = 0; i < 2; i++) {
+    auto& layer = layers[i];
+    auto map = &vram[0x1800 + 0x400 * i];
+    for (int block_y = 0; block_y < 32; block_y++) {
+      for (int block_x = 0; block_x < 32; block_x++) {
+        auto tile = GetBGTileNumber(layer.tile_select, map[block_y * 32 + block_x]);
+        if (tile_is_dirty[tile]) {
+          layer.entry_is_dirty[block_y][block_x] = true;
+          layer.row_is_dirty[block_y] = true;
+        }
+      }
+    }
+  }
+
+  for (auto& dirty : tile_is_dirty) {
+    dirty = false;
+  }
+  any_tile_is_dirty = false;
+}
+
+auto Renderer::GetLayerRow(int map_select, int tile_select, int y) -> std::uint8_t const* {
+  auto& layer = layers[map_select];
+
+  if (layer.tile_select != tile_select) {
+    layer.tile_select = tile_select;
+    MarkLayerDirty(layer);
+  }
+
+  UpdateDirtyTiles();
+
+  auto block_y = y >> 3;
+  if (layer.row_is_dirty[block_y]) {
+    auto map = &vram[0x1800 + 0x400 * map_select + block_y * 32];
+    for (int block_x = 0; block_x < 32; block_x++) {
+      if (!layer.entry_is_dirty[block_y][block_x]) {
+        continue;
+      }
+      auto tile = GetBGTileNumber(tile_select, map[block_x]);
+      for (int tile_y = 0; tile_y < 8; tile_y++) {
+        std::memcpy(&layer.pixels[block_y * 8 + tile_y][block_x * 8], tile_cache[tile][tile_y], 8);
+      }
+      layer.entry_is_dirty[block_y][block_x] = false;
+    }
+    layer.row_is_dirty[block_y] = false;
+  }
+
+  return layer.pixels[y];
+}
+
+void Renderer::RenderBackground(Scanline const& line) {
+  auto map_y = (line.ly + line.scy) & 0xFF;
+  auto row = GetLayerRow(line.lcdc.bg_map_select, line.lcdc.bg_win_tile_select, map_y);
+
+  // Copy 160 pixels starting at SCX, wrapping around at the end of the layer.
+  auto count = std::min(256 - line.scx, 160);
+  std::memcpy(line_bg, &row[line.scx], count);
+  std::memcpy(&line_bg[count], row, 160 - count);
+}
+
+void Renderer::RenderWindow(Scanline const& line) {
+  auto screen_x = line.wx - 7;
+  if (screen_x >= 160) {
+    return;
+  }
+
+  auto row = GetLayerRow(line.lcdc.win_map_select, line.lcdc.bg_win_tile_select, line.ly - line.wy);
+  auto first = std::max(screen_x, 0);
+  std::memcpy(&line_bg[first], &row[first - screen_x], 160 - first);
+}
+
+void Renderer::RenderSprites(Scanline const& line) {
+  auto double_size = line.lcdc.obj_double_size;
+
+  for (int i = line.obj_count - 1; i >= 0; i--) {
+    auto sprite = &line.objs[i];
+    auto x = int(sprite->x) - 8;
+    auto y = int(sprite->y) - 16;
+    auto tile = sprite->tile;
+    auto tile_y = line.ly - y;
+    if (sprite->flip_y) {
+      tile_y ^= double_size ? 15 : 7;
+    }
+    if (double_size) {
+      tile = (tile & ~1) | (tile_y >> 3);
+      tile_y &= 7;
+    }
+    auto row = tile_cache[tile][tile_y];
+    auto x_xor = sprite->flip_x ? 7 : 0;
+    auto palette = sprite->palette << 2;
+    for (int tile_x = 0; tile_x < 8; tile_x++) {
+      auto palette_index = row[tile_x];
+      if (palette_index == 0) {
+        continue;
+      }
+      auto screen_x = x + (tile_x ^ x_xor);
+      if (screen_x >= 0 && screen_x < 160 && (!sprite->behind_bg || line_bg[screen_x] == 0)) {
+        line_obj[screen_x] = palette_index | palette;
+      }
+    }
+  }
+}
+
+void Renderer::UpdatePalette(int base, std::uint8_t value) {
+  for (int i = 0; i < 4; i++) {
+    shades[base + i] = (value >> (i * 2)) & 3;
+    palette[base + i] = kColorPalette[shades[base + i]];
+  }
+}
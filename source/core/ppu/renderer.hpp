@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/// Frame buffer formats. All formats store 160 pixels per line,
+/// the first pixel of a line at the lowest address.
+enum class PixelFormat {
+  /// 32-bit 0xAARRGGBB
+  ARGB8888,
+  /// 16-bit RGB565
+  RGB565,
+  /// 8-bit grayscale
+  Gray8,
+  /// 2-bit shade (0 = lightest, 3 = darkest), packed four pixels per byte,
+  /// the first pixel in the lowest bits.
+  Shade2
+};
+
+/// Draws scanlines from a snapshot of the PPU registers and OBJs.
+/// Keeps its own copy of VRAM, so that it can run apart from the PPU.
+class Renderer {
+public:
+  struct LCDC {
+    bool enable_bg = false;
+    bool enable_obj = false;
+    bool obj_double_size = false;
+    int bg_map_select = 0;
+    int bg_win_tile_select = 0;
+    bool enable_win = false;
+    int win_map_select = 0;
+    bool enable_display = false;
+  };
+
+  /// OBJ with pre-decoded information.
+  struct OAM {
+    std::uint8_t x;
+    std::uint8_t y;
+    std::uint8_t tile;
+    int palette;
+    bool flip_x;
+    bool flip_y;
+    bool behind_bg;
+  };
+
+  /// Everything besides VRAM that a scanline depends on.
+  struct Scanline {
+    void* buffer;
+    PixelFormat format;
+    LCDC lcdc;
+    std::uint8_t ly;
+    std::uint8_t scy;
+    std::uint8_t scx;
+    std::uint8_t wy;
+    std::uint8_t wx;
+    std::uint8_t bgp;
+    std::uint8_t obp[2];
+
+    /// Up to 10 OBJs on this scanline, sorted by priority in ascending order.
+    int obj_count;
+    OAM objs[10];
+  };
+
+  Renderer() { Reset(); }
+
+  void Reset();
+  void WriteVRAM(std::uint16_t offset, std::uint8_t value);
+  void Render(Scanline const& line);
+
+  static constexpr std::uint32_t kColorPalette[4] = {
+    0xFFFFFFFF, 0xFF606060, 0xFF202020, 0xFF000000 };
+
+private:
+  std::uint8_t vram[0x2000];
+
+  /// Tile data decoded into one palette index per pixel, indexed by
+  /// tile number (0 - 383), row and column.
+  std::uint8_t tile_cache[384][8][8];
+
+  /// Both tile maps (0x9800 and 0x9C00) decoded into 256x256 palette indices.
+  /// Map entries are decoded again on first use after the entry or its tile
+  /// data changed, or after the tile data select changed.
+  struct Layer {
+    std::uint8_t pixels[256][256];
+    int tile_select;
+    bool entry_is_dirty[32][32];
+    bool row_is_dirty[32];
+  } layers[2];
+
+  /// Tiles whose data changed since the layers were last checked for them.
+  bool tile_is_dirty[384];
+  bool any_tile_is_dirty;
+
+  /// BG and window palette indices of the current scanline.
+  std::uint8_t line_bg[160];
+
+  /// Visible OBJ pixels of the current scanline as palette index | palette << 2.
+  /// Zero where no OBJ pixel is visible.
+  std::uint8_t line_obj[160];
+
+  /// Resolved shades and colors, indexed by BG palette index (0 - 3) or by
+  /// OBJ pixel | 8 (8 - 15). The PPU does not touch them on BGP, OBP0 or
+  /// OBP1 writes, since the render thread may still draw lines with the old
+  /// values. Instead they are rebuilt on the first line drawn with new values.
+  std::uint8_t bgp;
+  std::uint8_t obp[2];
+  std::uint8_t shades[16];
+  std::uint32_t palette[16];
+
+  auto GetBGTileNumber(int tile_select, std::uint8_t tile) -> int;
+  void MarkLayerDirty(Layer& layer);
+  void UpdateDirtyTiles();
+  auto GetLayerRow(int map_select, int tile_select, int y) -> std::uint8_t const*;
+  void RenderBackground(Scanline const& line);
+  void RenderWindow(Scanline const& line);
+  void RenderSprites(Scanline const& line);
+  void ComposeKeys(std::uint8_t* keys);
+  template <PixelFormat format>
+  void ComposeScanline(Scanline const& line);
+  void UpdatePalette(int base, std::uint8_t value);
+};
@@ -8,35 +8,62 @@
 #pragma once
 
 #include <cstdint>
-#include <functional>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
 
+/// The event queue defaults to a small sorted array, which beats a binary heap
+/// for the dozen events that are alive at any time. Define REBOY_SCHEDULER_HEAP
+/// to use a binary heap instead.
 class Scheduler {
 public:
-  struct Event {
-    std::function<void(int)> callback;
+  /// Event slot owned by a subsystem. A slot is registered once and can then
+  /// be rescheduled any number of times without allocating.
+  class Event {
+  public:
+    using Callback = void (*)(void* context, int cycles_late);
+
+    auto IsScheduled() const -> bool { return index >= 0; }
+    auto GetTimestamp() const -> std::uint64_t { return timestamp; }
+
   private:
     friend class Scheduler;
-    int handle;
-    std::uint64_t timestamp;
+    Callback callback = nullptr;
+    void* context = nullptr;
+    std::uint64_t timestamp = 0;
+    /// Registration order, breaks ties between events due at the same time.
+    int id = 0;
+    /// Position in the queue, -1 if not scheduled.
+    int index = -1;
   };
 
   Scheduler() {
-    for (int i = 0; i < kMaxEvents; i++) {
-      heap[i] = new Event();
-      heap[i]->handle = i;
-    }
     Reset();
   }
 
-  ~Scheduler() {
-    for (int i = 0; i < kMaxEvents; i++) {
-      delete heap[i];
+  void Reset() {
+    for (int i = 0; i < event_count; i++) {
+      events[i]->index = -1;
     }
+    queue.Clear();
+    timestamp_now = 0;
   }
 
-  void Reset() {
-    heap_size = 0;
-    timestamp_now = 0;
+  /// Registers a slot that calls `method` on `object` when it fires.
+  /// Every slot fits into the queue at once, so scheduling can never overflow.
+  template <typename T, void (T::*method)(int)>
+  void Register(Event* event, T* object) {
+    if (event_count == kMaxEvents) {
+      std::puts("Scheduler: too many event slots registered");
+      std::abort();
+    }
+    event->callback = [](void* context, int cycles_late) {
+      (static_cast<T*>(context)->*method)(cycles_late);
+    };
+    event->context = object;
+    event->id = event_count;
+    event->index = -1;
+    events[event_count++] = event;
   }
 
   auto GetTimestampNow() const -> std::uint64_t {
@@ -44,93 +71,166 @@ public:
   }
 
   auto GetTimestampTarget() const -> std::uint64_t {
-    return heap[0]->timestamp;
+    auto event = queue.Front();
+    if (event == nullptr)
+      return std::numeric_limits<std::uint64_t>::max();
+    return event->timestamp;
   }
 
   auto GetRemainingCycleCount() const -> int {
-    return int(GetTimestampTarget() - GetTimestampNow());
+    auto remaining = GetTimestampTarget() - GetTimestampNow();
+    if (remaining > std::uint64_t(std::numeric_limits<int>::max()))
+      return std::numeric_limits<int>::max();
+    return int(remaining);
   }
 
   void AddCycles(int cycles) {
     timestamp_now += cycles;
   }
 
-  auto Add(std::uint64_t delay, std::function<void(int)> callback) -> Event* {
-    int n = heap_size++;
-    int p = Parent(n);
-
-    auto event = heap[n];
+  /// Schedules a slot `delay` cycles from now, replacing its previous time.
+  void Add(Event* event, std::uint64_t delay) {
+    if (event->IsScheduled())
+      queue.Remove(event);
     event->timestamp = GetTimestampNow() + delay;
-    event->callback = callback;
-
-    while (n != 0 && heap[p]->timestamp > heap[n]->timestamp) {
-      Swap(n, p);
-      n = p;
-      p = Parent(n);
-    }
-
-    return event;
+    queue.Insert(event);
   }
 
   void Cancel(Event* event) {
-    Remove(event->handle);
+    if (event->IsScheduled())
+      queue.Remove(event);
   }
 
   void Step() {
     auto now = GetTimestampNow();
-    while (heap_size > 0 && heap[0]->timestamp <= now) {
-      auto event = heap[0];
-      Remove(0);
-      event->callback(int(now - event->timestamp));
+    for (;;) {
+      auto event = queue.Front();
+      if (event == nullptr || event->timestamp > now)
+        break;
+      queue.Remove(event);
+      event->callback(event->context, int(now - event->timestamp));
     }
   }
 
 private:
-  static constexpr int kMaxEvents = 64;
-
-  constexpr int Parent(int n) { return (n - 1) / 2; }
-  constexpr int LeftChild(int n) { return n * 2 + 1; }
-  constexpr int RightChild(int n) { return n * 2 + 2; }
-
-  void Remove(int n) {
-    Swap(n, --heap_size);
-
-    int p = Parent(n);
-    if (n != 0 && heap[p]->timestamp > heap[n]->timestamp) {
-      do {
-        Swap(n, p);
-        n = p;
-        p = Parent(n);
-      } while (n != 0 && heap[p]->timestamp > heap[n]->timestamp);
-    } else {
-      Heapify(n);
-    }
-  }
+  static constexpr int kMaxEvents = 16;
 
-  void Swap(int i, int j) {
-    auto tmp = heap[i];
-    heap[i] = heap[j];
-    heap[j] = tmp;
-    heap[i]->handle = i;
-    heap[j]->handle = j;
+  static constexpr auto Before(Event const* a, Event const* b) -> bool {
+    return a->timestamp < b->timestamp || (a->timestamp == b->timestamp && a->id < b->id);
   }
 
-  void Heapify(int n) {
-    int l = LeftChild(n);
-    int r = RightChild(n);
+  /// Events sorted by descending time, so that the next event is the last one.
+  class SortedQueue {
+  public:
+    void Clear() { size = 0; }
 
-    if (l < heap_size && heap[l]->timestamp < heap[n]->timestamp) {
-      Swap(l, n);
-      Heapify(l);
+    auto Front() const -> Event* {
+      return size == 0 ? nullptr : list[size - 1];
     }
 
-    if (r < heap_size && heap[r]->timestamp < heap[n]->timestamp) {
-      Swap(r, n);
-      Heapify(r);
+    void Insert(Event* event) {
+      int i = size++;
+      while (i > 0 && Before(list[i - 1], event)) {
+        Place(list[i - 1], i);
+        i--;
+      }
+      Place(event, i);
     }
-  }
 
-  Event* heap[kMaxEvents];
-  int heap_size;
+    void Remove(Event* event) {
+      for (int i = event->index + 1; i < size; i++)
+        Place(list[i], i - 1);
+      event->index = -1;
+      size--;
+    }
+
+  private:
+    void Place(Event* event, int i) {
+      list[i] = event;
+      event->index = i;
+    }
+
+    Event* list[kMaxEvents];
+    int size = 0;
+  };
+
+  /// Binary min-heap of events.
+  class HeapQueue {
+  public:
+    void Clear() { size = 0; }
+
+    auto Front() const -> Event* {
+      return size == 0 ? nullptr : heap[0];
+    }
+
+    void Insert(Event* event) {
+      Place(event, size++);
+      SiftUp(event->index);
+    }
+
+    void Remove(Event* event) {
+      int n = event->index;
+      event->index = -1;
+      if (n == --size)
+        return;
+      Place(heap[size], n);
+      if (n != 0 && Before(heap[n], heap[Parent(n)])) {
+        SiftUp(n);
+      } else {
+        SiftDown(n);
+      }
+    }
+
+  private:
+    static constexpr int Parent(int n) { return (n - 1) / 2; }
+    static constexpr int LeftChild(int n) { return n * 2 + 1; }
+    static constexpr int RightChild(int n) { return n * 2 + 2; }
+
+    void Place(Event* event, int i) {
+      heap[i] = event;
+      event->index = i;
+    }
+
+    void Swap(int i, int j) {
+      auto tmp = heap[i];
+      Place(heap[j], i);
+      Place(tmp, j);
+    }
+
+    void SiftUp(int n) {
+      while (n != 0 && Before(heap[n], heap[Parent(n)])) {
+        Swap(n, Parent(n));
+        n = Parent(n);
+      }
+    }
+
+    void SiftDown(int n) {
+      for (;;) {
+        int l = LeftChild(n);
+        int r = RightChild(n);
+        int min = n;
+        if (l < size && Before(heap[l], heap[min]))
+          min = l;
+        if (r < size && Before(heap[r], heap[min]))
+          min = r;
+        if (min == n)
+          break;
+        Swap(n, min);
+        n = min;
+      }
+    }
+
+    Event* heap[kMaxEvents];
+    int size = 0;
+  };
+
+#if defined(REBOY_SCHEDULER_HEAP)
+  HeapQueue queue;
+#else
+  SortedQueue queue;
+#endif
+
+  Event* events[kMaxEvents];
+  int event_count = 0;
   std::uint64_t timestamp_now;
 };
@@ -7,45 +7,54 @@
 
 #include "timer.hpp"
 
+Timer::Timer(Scheduler* scheduler, IRQ* irq) : scheduler(scheduler), irq(irq) {
+  scheduler->Register<Timer, &Timer::OnOverflow>(&timer_event, this);
+  Reset();
+}
+
 void Timer::Reset() {
-  div = 255;
+  div_base = scheduler->GetTimestampNow();
   tima = 0;
+  tima_timestamp = scheduler->GetTimestampNow();
   tma = 0;
   tac = {};
-  timer_event = nullptr;
-  StepDIV(0);
+  scheduler->Cancel(&timer_event);
 }
 
-void Timer::StepDIV(int cycles_late) {
-  div++;
-  scheduler->Add(256 - cycles_late, [this](int cycles_late){StepDIV(cycles_late);});
+auto Timer::GetTimerPeriod() const -> int {
+  static constexpr int kTimerDuty[4] {
+    1024, 16, 64, 256 };
+  return kTimerDuty[static_cast<int>(tac.clock_select)];
 }
 
-void Timer::StepTimer(int cycles_late) {
-  if (tima == 255) {
-    tima = tma;
-    irq->Raise(IRQ::TIMER);
-  } else {
-    tima++;
-  }
+void Timer::UpdateTIMA() {
+  if (!tac.enabled)
+    return;
+  // The overflow event has fired already if TIMA wrapped around.
+  auto period = GetTimerPeriod();
+  auto ticks = (scheduler->GetTimestampNow() - tima_timestamp) / period;
+  tima += ticks;
+  tima_timestamp += ticks * period;
+}
 
-  // TODO: do we really need to check if the timer has been disabled?
-  if (tac.enabled)
-    ScheduleTimer(cycles_late);
+void Timer::ScheduleOverflow() {
+  auto overflow = tima_timestamp + (256 - tima) * GetTimerPeriod();
+  scheduler->Add(&timer_event, overflow - scheduler->GetTimestampNow());
 }
 
-void Timer::ScheduleTimer(int cycles_late) {
-  static constexpr int kTimerDuty[4] {
-    1024, 16, 64, 256 };
-  auto cycles = kTimerDuty[static_cast<int>(tac.clock_select)] - cycles_late;
-  timer_event = scheduler->Add(cycles, [this](int cycles_late){StepTimer(cycles_late);});
+void Timer::OnOverflow(int cycles_late) {
+  tima = tma;
+  tima_timestamp = scheduler->GetTimestampNow() - cycles_late;
+  irq->Raise(IRQ::TIMER);
+  ScheduleOverflow();
 }
 
 auto Timer::ReadMMIO(std::uint8_t reg) -> std::uint8_t {
   switch (reg) {
     case REG_DIV:
-      return div;
+      return std::uint8_t((scheduler->GetTimestampNow() >> 8) - (div_base >> 8));
     case REG_TIMA:
+      UpdateTIMA();
       return tima;
     case REG_TMA:
       return tma;
@@ -59,30 +68,34 @@ auto Timer::ReadMMIO(std::uint8_t reg) -> std::uint8_t {
 void Timer::WriteMMIO(std::uint8_t reg, std::uint8_t value) {
   switch (reg) {
     case REG_DIV:
-      div = 0;
+      div_base = scheduler->GetTimestampNow();
       break;
     case REG_TIMA:
       // TODO: does the actually write the TIMA value or do something else?
+      UpdateTIMA();
       tima = value;
+      if (tac.enabled)
+        ScheduleOverflow();
       break;
     case REG_TMA:
+      // TMA is only read on overflow, which does not move the overflow time.
       tma = value;
       break;
     case REG_TAC:
+      UpdateTIMA();
       auto enabled_old = tac.enabled;
       auto clock_select_old = tac.clock_select;
       tac.clock_select = static_cast<TAC::Clock>(value & 3);
       tac.enabled = value & 4;
-      if (tac.clock_select != clock_select_old && enabled_old && tac.enabled) {
-        scheduler->Cancel(timer_event);
-        ScheduleTimer(0);
-      }
       // TODO: handle clock frequency change.
       if (!enabled_old && tac.enabled) {
         tima = tma;
-        ScheduleTimer(0);
-      } else if (enabled_old && !tac.enabled) {
-        scheduler->Cancel(timer_event);
+      }
+      if (!tac.enabled) {
+        scheduler->Cancel(&timer_event);
+      } else if (!enabled_old || tac.clock_select != clock_select_old) {
+        tima_timestamp = scheduler->GetTimestampNow();
+        ScheduleOverflow();
       }
       break;
   }
@@ -12,7 +12,7 @@
 
 class Timer {
 public:
-  Timer(Scheduler* scheduler, IRQ* irq) : scheduler(scheduler), irq(irq) { Reset(); }
+  Timer(Scheduler* scheduler, IRQ* irq);
 
   void Reset();
   auto ReadMMIO(std::uint8_t reg) -> std::uint8_t;
@@ -28,8 +28,13 @@ private:
 
   Scheduler* scheduler;
   IRQ* irq;
-  std::uint8_t div;
+  /// Time DIV was last reset at. DIV counts the 256-cycle periods since
+  /// then, keeping the phase of the divider across resets.
+  std::uint64_t div_base;
+  /// TIMA is only updated when it is accessed or overflows. The value holds
+  /// at `tima_timestamp`, which is aligned to the timer clock.
   std::uint8_t tima;
+  std::uint64_t tima_timestamp;
   std::uint8_t tma;
   struct TAC {
     bool enabled = false;
@@ -40,9 +45,10 @@ private:
       _16384 = 3
     } clock_select = Clock::_4096;
   } tac;
-  Scheduler::Event* timer_event;
+  Scheduler::Event timer_event;
 
-  void StepDIV(int cycles_late);
-  void StepTimer(int cycles_late);
-  void ScheduleTimer(int cycles_late);
+  auto GetTimerPeriod() const -> int;
+  void UpdateTIMA();
+  void ScheduleOverflow();
+  void OnOverflow(int cycles_late);
 };
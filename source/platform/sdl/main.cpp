@@ -14,11 +14,11 @@
 static std::uint32_t g_buffer[160 * 144];
 
 void usage(const char* name) {
-  std::printf("%s rom_path.gb\n", name);
+  std::printf("%s rom_path.gb [aot_module]\n", name);
 }
 
 int main(int argc, char** argv) {
-  if (argc != 2) {
+  if (argc != 2 && argc != 3) {
     usage(argc == 0 ? nullptr : argv[0]);
     return -1;
   }
@@ -47,6 +47,13 @@ int main(int argc, char** argv) {
     return -3;
   }
 
+  if (argc == 3) {
+    if (!gameboy->LoadAOTModule(std::string{argv[2]})) {
+      return -4;
+    }
+    gameboy->SetCPUBackend(CPUBackend::Precompiled);
+  }
+
   auto audio_device = new SDL2_AudioDevice();
   gameboy->SetAudioDevice(audio_device);
 
@@ -68,7 +75,8 @@ int main(int argc, char** argv) {
       time_start = SDL_GetTicks();
     }
 
-    SDL_UpdateTexture(texture, nullptr, g_buffer, sizeof(std::uint32_t) * 160);
+    if (!gameboy->IsFrameUnchanged())
+      SDL_UpdateTexture(texture, nullptr, g_buffer, sizeof(std::uint32_t) * 160);
     SDL_RenderClear(renderer);
     SDL_RenderCopy(renderer, texture, nullptr, nullptr);
     SDL_RenderPresent(renderer);
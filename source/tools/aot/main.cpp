@@ -0,0 +1,618 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../core/cpu/aot/aot.hpp"
+#include "../../core/cpu/opcode_info.hpp"
+
+/// Entry points besides the targets of RST instructions.
+static constexpr std::uint16_t kEntryPoints[] = {
+  0x0100, // cartridge entry after the BOOTROM
+  0x0040, 0x0048, 0x0050, 0x0058, 0x0060 // interrupt vectors
+};
+
+static const char* kRegName[8] = {
+  "s->b", "s->c", "s->d", "s->e", "s->h", "s->l", nullptr, "s->a"
+};
+
+/// BC, DE, HL
+static const char* kPairName[3] = {
+  "std::uint16_t((s->b << 8) | s->c)",
+  "std::uint16_t((s->d << 8) | s->e)",
+  "std::uint16_t((s->h << 8) | s->l)"
+};
+
+static const char* kHL = "std::uint16_t((s->h << 8) | s->l)";
+
+static const char* kCondition[4] = {
+  "!(s->f & 0x80)", "(s->f & 0x80)", "!(s->f & 0x10)", "(s->f & 0x10)"
+};
+
+struct Instruction {
+  std::uint16_t address;
+  std::uint8_t opcode;
+  std::uint8_t length;
+  std::uint8_t imm[2];
+};
+
+struct Block {
+  int bank;
+  std::uint16_t address;
+  std::vector<Instruction> instructions;
+};
+
+class ROM {
+public:
+  ROM(std::vector<std::uint8_t> data) : data(std::move(data)) {}
+
+  auto GetBankCount() const -> int { return int(data.size() >> 14); }
+
+  auto Read(int bank, std::uint16_t address) const -> std::uint8_t {
+    std::size_t offset = address;
+    if (address >= 0x4000)
+      offset = (bank << 14) | (address & 0x3FFF);
+    if (offset >= data.size())
+      return 0xFF;
+    return data[offset];
+  }
+
+  /// Maps an address to the bank it is executed from, assuming that `bank` is
+  /// mapped to 0x4000 - 0x7FFF. Returns -1 if the address does not map to ROM.
+  static auto GetBank(int bank, std::uint16_t address) -> int {
+    if (address <= 0x3FFF)
+      return 0;
+    if (address <= 0x7FFF)
+      return bank;
+    return -1;
+  }
+
+  std::vector<std::uint8_t> data;
+};
+
+/// Decodes a block exactly like CPU::DecodeBlock does at runtime.
+static auto DecodeBlock(ROM const& rom, int bank, std::uint16_t address) -> Block {
+  Block block {bank, address, {}};
+
+  while (block.instructions.size() < kMaxBlockLength) {
+    auto opcode = rom.Read(bank, address);
+    auto length = kOpcodeLength[opcode];
+
+    if (ROM::GetBank(bank, address + length - 1) != bank)
+      break;
+
+    Instruction instruction {address, opcode, length, {0, 0}};
+    for (int i = 1; i < length; i++)
+      instruction.imm[i - 1] = rom.Read(bank, address + i);
+    block.instructions.push_back(instruction);
+
+    address += length;
+    if (EndsBlock(opcode))
+      break;
+  }
+
+  return block;
+}
+
+/// Collects the statically known addresses execution may continue at after a block.
+static auto GetSuccessors(Block const& block) -> std::vector<std::uint16_t> {
+  std::vector<std::uint16_t> successors;
+
+  auto& last = block.instructions.back();
+  auto opcode = last.opcode;
+  std::uint16_t next = last.address + last.length;
+  std::uint16_t imm16 = last.imm[0] | (last.imm[1] << 8);
+
+  if (!EndsBlock(opcode)) {
+    successors.push_back(next);
+    return successors;
+  }
+
+  switch (opcode) {
+    // STOP, HALT
+    case 0x10:
+    case 0x76:
+      successors.push_back(next);
+      break;
+    // JR
+    case 0x18:
+      successors.push_back(next + std::int8_t(last.imm[0]));
+      break;
+    case 0x20: case 0x28: case 0x30: case 0x38:
+      successors.push_back(next + std::int8_t(last.imm[0]));
+      successors.push_back(next);
+      break;
+    // JP
+    case 0xC3:
+      successors.push_back(imm16);
+      break;
+    case 0xC2: case 0xCA: case 0xD2: case 0xDA:
+    // CALL
+    case 0xC4: case 0xCC: case 0xCD: case 0xD4: case 0xDC:
+      successors.push_back(imm16);
+      successors.push_back(next);
+      break;
+    // RET cc
+    case 0xC0: case 0xC8: case 0xD0: case 0xD8:
+      successors.push_back(next);
+      break;
+    // RST
+    case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+    case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+      successors.push_back(opcode & 0x38);
+      successors.push_back(next);
+      break;
+    // JP HL, RET, RETI and unused opcodes are resolved at runtime.
+  }
+
+  return successors;
+}
+
+/// Walks all code reachable from the entry points.
+/// Code in bank 0 may jump to any switchable bank, since the mapped bank is unknown.
+static auto FindBlocks(ROM const& rom) -> std::vector<Block> {
+  std::vector<Block> blocks;
+  std::set<std::pair<int, std::uint16_t>> visited;
+  std::deque<std::pair<int, std::uint16_t>> queue;
+
+  auto enqueue = [&](int from_bank, std::uint16_t address) {
+    auto bank = ROM::GetBank(from_bank, address);
+    if (bank < 0)
+      return;
+    if (bank == 0 && address >= 0x4000) {
+      for (int i = 1; i < rom.GetBankCount(); i++)
+        queue.emplace_back(i, address);
+    } else {
+      queue.emplace_back(bank, address);
+    }
+  };
+
+  for (auto address : kEntryPoints)
+    queue.emplace_back(0, address);
+
+  while (!queue.empty()) {
+    auto entry = queue.front();
+    queue.pop_front();
+
+    if (!visited.insert(entry).second)
+      continue;
+
+    auto block = DecodeBlock(rom, entry.first, entry.second);
+    if (block.instructions.empty())
+      continue;
+
+    for (auto address : GetSuccessors(block))
+      enqueue(block.bank, address);
+    blocks.push_back(std::move(block));
+  }
+
+  return blocks;
+}
+
+static void EmitTicks(std::FILE* file, int count, int indent = 2) {
+  if (count > 0)
+    std::fprintf(file, "%*ss->tick(s, %d);\n", indent, "", count);
+}
+
+/// Emits C++ for a CB prefixed instruction, see EmitInstruction().
+static bool EmitInstructionCB(std::FILE* file, std::uint16_t next, std::uint8_t opcode) {
+  int bit = (opcode >> 3) & 7;
+  int reg = opcode & 7;
+
+  EmitTicks(file, 2);
+  std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+
+  if (reg != 6) {
+    auto name = kRegName[reg];
+    switch (opcode >> 6) {
+      case 0: std::fprintf(file, "  %s = AOTShift(s, %d, %s);\n", name, bit, name); break;
+      case 1: std::fprintf(file, "  AOTBit(s, %d, %s);\n", bit, name); break;
+      case 2: std::fprintf(file, "  %s &= 0x%02X;\n", name, ~(1 << bit) & 0xFF); break;
+      case 3: std::fprintf(file, "  %s |= 0x%02X;\n", name, 1 << bit); break;
+    }
+    return true;
+  }
+
+  std::fprintf(file, "  {\n    auto address = %s;\n", kHL);
+  switch (opcode >> 6) {
+    case 0: std::fprintf(file, "    s->write(s, address, AOTShift(s, %d, s->read(s, address)));\n", bit); break;
+    case 1: std::fprintf(file, "    AOTBit(s, %d, s->read(s, address));\n", bit); break;
+    case 2: std::fprintf(file, "    s->write(s, address, s->read(s, address) & 0x%02X);\n", ~(1 << bit) & 0xFF); break;
+    case 3: std::fprintf(file, "    s->write(s, address, s->read(s, address) | 0x%02X);\n", 1 << bit); break;
+  }
+  std::fprintf(file, "  }\n");
+  return (opcode >> 6) == 1;
+}
+
+/// Emits C++ for an instruction. Returns false if the instruction may have
+/// changed code, because it wrote memory or was left to the interpreter.
+static bool EmitInstruction(std::FILE* file, Instruction const& instruction) {
+  auto opcode = instruction.opcode;
+  int dst = (opcode >> 3) & 7;
+  int src = opcode & 7;
+  std::uint16_t next = instruction.address + instruction.length;
+  std::uint8_t imm8 = instruction.imm[0];
+  std::uint16_t imm16 = instruction.imm[0] | (instruction.imm[1] << 8);
+
+  // NOP
+  if (opcode == 0x00) {
+    EmitTicks(file, 1);
+    std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+    return true;
+  }
+
+  // LD r, r'
+  if (opcode >= 0x40 && opcode <= 0x7F && dst != 6 && src != 6) {
+    EmitTicks(file, 1);
+    std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+    std::fprintf(file, "  %s = %s;\n", kRegName[dst], kRegName[src]);
+    return true;
+  }
+
+  // LD r, u8
+  if ((opcode & 0xC7) == 0x06 && dst != 6) {
+    EmitTicks(file, 2);
+    std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+    std::fprintf(file, "  %s = 0x%02X;\n", kRegName[dst], imm8);
+    return true;
+  }
+
+  // LD rr, u16
+  if ((opcode & 0xCF) == 0x01) {
+    EmitTicks(file, 3);
+    std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+    if (opcode == 0x31) {
+      std::fprintf(file, "  s->sp = 0x%04X;\n", imm16);
+    } else {
+      auto index = (opcode >> 4) * 2;
+      std::fprintf(file, "  %s = 0x%02X;\n", kRegName[index + 0], imm16 >> 8);
+      std::fprintf(file, "  %s = 0x%02X;\n", kRegName[index + 1], imm16 & 0xFF);
+    }
+    return true;
+  }
+
+  // INC rr, DEC rr
+  if ((opcode & 0xC7) == 0x03) {
+    auto delta = (opcode & 8) ? -1 : 1;
+    EmitTicks(file, 1);
+    std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+    if ((opcode >> 4) == 3) {
+      std::fprintf(file, "  s->sp += %d;\n", delta);
+    } else {
+      auto index = (opcode >> 4) * 2;
+      std::fprintf(file, "  AOTAddPair(%s, %s, %d);\n", kRegName[index + 0], kRegName[index + 1], delta);
+    }
+    return true;
+  }
+
+  // INC r, DEC r
+  if ((opcode & 0xC6) == 0x04 && dst != 6) {
+    EmitTicks(file, 1);
+    std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+    std::fprintf(file, "  %s(s, %s);\n", (opcode & 1) ? "AOTDec" : "AOTInc", kRegName[dst]);
+    return true;
+  }
+
+  // LD r, (HL)
+  if ((opcode & 0xC7) == 0x46 && opcode != 0x76) {
+    EmitTicks(file, 1);
+    std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+    std::fprintf(file, "  %s = s->read(s, %s);\n", kRegName[dst], kHL);
+    return true;
+  }
+
+  // LD (HL), r
+  if ((opcode & 0xF8) == 0x70 && opcode != 0x76) {
+    EmitTicks(file, 1);
+    std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+    std::fprintf(file, "  s->write(s, %s, %s);\n", kHL, kRegName[src]);
+    return false;
+  }
+
+  switch (opcode) {
+    // LD (HL), u8
+    case 0x36:
+      EmitTicks(file, 2);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  s->write(s, %s, 0x%02X);\n", kHL, imm8);
+      return false;
+    // LD (BC), A and LD (DE), A
+    case 0x02: case 0x12:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  s->write(s, %s, s->a);\n", kPairName[opcode >> 4]);
+      return false;
+    // LD A, (BC) and LD A, (DE)
+    case 0x0A: case 0x1A:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  s->a = s->read(s, %s);\n", kPairName[opcode >> 4]);
+      return true;
+    // LD (HL+), A and LD (HL-), A
+    case 0x22: case 0x32:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  s->write(s, %s, s->a);\n", kHL);
+      std::fprintf(file, "  AOTAddPair(s->h, s->l, %d);\n", opcode == 0x22 ? 1 : -1);
+      return false;
+    // LD A, (HL+) and LD A, (HL-)
+    case 0x2A: case 0x3A:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  s->a = s->read(s, %s);\n", kHL);
+      std::fprintf(file, "  AOTAddPair(s->h, s->l, %d);\n", opcode == 0x2A ? 1 : -1);
+      return true;
+    // LDH (u8), A and LDH A, (u8)
+    case 0xE0: case 0xF0:
+      EmitTicks(file, 2);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      if (opcode == 0xE0)
+        std::fprintf(file, "  s->write(s, 0x%04X, s->a);\n", 0xFF00 + imm8);
+      else
+        std::fprintf(file, "  s->a = s->read(s, 0x%04X);\n", 0xFF00 + imm8);
+      return opcode == 0xF0;
+    // LD (FF00 + C), A and LD A, (FF00 + C)
+    case 0xE2: case 0xF2:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      if (opcode == 0xE2)
+        std::fprintf(file, "  s->write(s, 0xFF00 + s->c, s->a);\n");
+      else
+        std::fprintf(file, "  s->a = s->read(s, 0xFF00 + s->c);\n");
+      return opcode == 0xF2;
+    // LD (u16), A and LD A, (u16)
+    case 0xEA: case 0xFA:
+      EmitTicks(file, 3);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      if (opcode == 0xEA)
+        std::fprintf(file, "  s->write(s, 0x%04X, s->a);\n", imm16);
+      else
+        std::fprintf(file, "  s->a = s->read(s, 0x%04X);\n", imm16);
+      return opcode == 0xFA;
+    // LD (u16), SP
+    case 0x08:
+      EmitTicks(file, 3);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  s->write(s, 0x%04X, s->sp & 0xFF);\n", imm16);
+      std::fprintf(file, "  s->write(s, 0x%04X, s->sp >> 8);\n", std::uint16_t(imm16 + 1));
+      return false;
+    // LD SP, HL
+    case 0xF9:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  s->sp = %s;\n", kHL);
+      return true;
+    // INC (HL) and DEC (HL)
+    case 0x34: case 0x35:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  AOTIncDecHL(s, %d);\n", opcode == 0x34 ? 1 : -1);
+      return false;
+    // ADD HL, rr
+    case 0x09: case 0x19: case 0x29: case 0x39:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  AOTAddHL(s, %s);\n", opcode == 0x39 ? "s->sp" : kPairName[opcode >> 4]);
+      return true;
+    // RLCA, RRCA, RLA and RRA always clear the zero flag.
+    case 0x07: case 0x0F: case 0x17: case 0x1F:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  s->a = AOTShift(s, %d, s->a);\n  s->f &= 0x10;\n", opcode >> 3);
+      return true;
+    // CPL, SCF, CCF
+    case 0x2F: case 0x37: case 0x3F:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      if (opcode == 0x2F)
+        std::fprintf(file, "  s->a ^= 0xFF;\n  s->f |= 0x60;\n");
+      else if (opcode == 0x37)
+        std::fprintf(file, "  s->f = (s->f & 0x80) | 0x10;\n");
+      else
+        std::fprintf(file, "  s->f = (s->f & 0x90) ^ 0x10;\n");
+      return true;
+    // PUSH rr
+    case 0xC5: case 0xD5: case 0xE5: case 0xF5:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  AOTPush(s, %s);\n",
+        opcode == 0xF5 ? "std::uint16_t((s->a << 8) | s->f)" : kPairName[(opcode >> 4) & 3]);
+      return false;
+    // POP rr, the low nibble of F always reads as zero.
+    case 0xC1: case 0xD1: case 0xE1: case 0xF1: {
+      auto index = ((opcode >> 4) & 3) * 2;
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = 0x%04X;\n", next);
+      std::fprintf(file, "  {\n    auto value = AOTPop(s);\n");
+      if (opcode == 0xF1) {
+        std::fprintf(file, "    s->a = value >> 8;\n    s->f = value & 0xF0;\n  }\n");
+      } else {
+        std::fprintf(file, "    %s = value >> 8;\n    %s = value & 0xFF;\n  }\n", kRegName[index + 0], kRegName[index + 1]);
+      }
+      return true;
+    }
+    // CALL u16
+    case 0xCD:
+      EmitTicks(file, 3);
+      std::fprintf(file, "  AOTPush(s, 0x%04X);\n  s->pc = 0x%04X;\n", next, imm16);
+      return false;
+    // CALL cc, u16, does not fetch its target if not taken.
+    case 0xC4: case 0xCC: case 0xD4: case 0xDC:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  if (%s) {\n", kCondition[(opcode >> 3) & 3]);
+      EmitTicks(file, 2, 4);
+      std::fprintf(file, "    AOTPush(s, 0x%04X);\n    s->pc = 0x%04X;\n  } else {\n    s->pc = 0x%04X;\n  }\n", next, imm16, next);
+      return false;
+    // RET
+    case 0xC9:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = AOTPop(s);\n");
+      return true;
+    // RET cc
+    case 0xC0: case 0xC8: case 0xD0: case 0xD8:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = %s ? AOTPop(s) : 0x%04X;\n", kCondition[(opcode >> 3) & 3], next);
+      return true;
+    // RST
+    case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+    case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  AOTPush(s, 0x%04X);\n  s->pc = 0x%04X;\n", next, opcode & 0x38);
+      return false;
+    // JP HL
+    case 0xE9:
+      EmitTicks(file, 1);
+      std::fprintf(file, "  s->pc = %s;\n", kHL);
+      return true;
+    // CB prefix
+    case 0xCB:
+      return EmitInstructionCB(file, next, imm8);
+  }
+
+  // ALU A, r, ALU A, (HL) and ALU A, u8
+  if ((opcode >= 0x80 && opcode <= 0xBF) || (opcode & 0xC7) == 0xC6) {
+    static const char* kALU[8] = {
+      "AOTAdd(s, %s, 0)",
+      "AOTAdd(s, %s, (s->f >> 4) & 1)",
+      "AOTSub(s, %s, 0, true)",
+      "AOTSub(s, %s, (s->f >> 4) & 1, true)",
+      "AOTAnd(s, %s)",
+      "AOTXor(s, %s)",
+      "AOTOr(s, %s)",
+      "AOTSub(s, %s, 0, false)"
+    };
+    bool immediate = opcode >= 0xC0;
+    char operand[64];
+    if (immediate)
+      std::snprintf(operand, sizeof(operand), "0x%02X", imm8);
+    else if (src == 6)
+      std::snprintf(operand, sizeof(operand), "s->read(s, %s)", kHL);
+    else
+      std::snprintf(operand, sizeof(operand), "%s", kRegName[src]);
+    EmitTicks(file, immediate ? 2 : 1);
+    std::fprintf(file, "  s->pc = 0x%04X;\n  ", next);
+    std::fprintf(file, kALU[dst], operand);
+    std::fprintf(file, ";\n");
+    return true;
+  }
+
+  // JR and JP, conditional branches do not fetch their target if not taken.
+  if (opcode == 0x18 || opcode == 0xC3) {
+    EmitTicks(file, instruction.length);
+    std::fprintf(file, "  s->pc = 0x%04X;\n",
+      opcode == 0x18 ? std::uint16_t(next + std::int8_t(imm8)) : imm16);
+    return true;
+  }
+  if ((opcode & 0xE7) == 0x20 || (opcode & 0xE7) == 0xC2) {
+    bool relative = opcode < 0x40;
+    EmitTicks(file, 1);
+    std::fprintf(file, "  if (%s) {\n", kCondition[(opcode >> 3) & 3]);
+    EmitTicks(file, instruction.length - 1, 4);
+    std::fprintf(file, "    s->pc = 0x%04X;\n  } else {\n    s->pc = 0x%04X;\n  }\n",
+      relative ? std::uint16_t(next + std::int8_t(imm8)) : imm16, next);
+    return true;
+  }
+
+  std::fprintf(file, "  s->execute(s, 0x%02X, 0x%02X, 0x%02X);\n",
+    opcode, instruction.imm[0], instruction.imm[1]);
+  return false;
+}
+
+static void EmitBlock(std::FILE* file, Block const& block) {
+  auto& instructions = block.instructions;
+
+  std::fprintf(file, "static bool Block_%02X_%04X(AOTState* s) {\n", block.bank, block.address);
+  std::fprintf(file, "  auto generation = *s->code_generation;\n");
+  std::fprintf(file, "  (void)generation;\n");
+
+  for (std::size_t i = 0; i < instructions.size(); i++) {
+    auto& instruction = instructions[i];
+
+    std::fprintf(file, "  // 0x%04X: %02X", instruction.address, instruction.opcode);
+    for (int j = 1; j < instruction.length; j++)
+      std::fprintf(file, " %02X", instruction.imm[j - 1]);
+    std::fprintf(file, "\n");
+
+    bool keeps_code = EmitInstruction(file, instruction);
+    if (i == instructions.size() - 1)
+      break;
+
+    if (keeps_code)
+      std::fprintf(file, "  if (AOTShouldReturn(s)) return false;\n");
+    else
+      std::fprintf(file, "  if (AOTShouldReturn(s) || *s->code_generation != generation) return false;\n");
+  }
+
+  std::fprintf(file, "  return true;\n}\n\n");
+}
+
+static void usage(const char* name) {
+  std::printf("%s rom_path.gb output.cpp\n", name);
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    usage(argc == 0 ? "ReBoyAOT" : argv[0]);
+    return -1;
+  }
+
+  std::ifstream input {argv[1], std::ios::in | std::ios::binary};
+  if (!input.good()) {
+    std::printf("Failed to open ROM: %s\n", argv[1]);
+    return -1;
+  }
+
+  input.seekg(0, std::ios::end);
+  size_t size = input.tellg();
+  input.seekg(0);
+
+  if (size == 0 || (size & 0x3FFF) != 0 || (size >> 14) > 256) {
+    std::puts("ROM size must be a non-zero multiple of 16 KiB and at most 4 MiB");
+    return -1;
+  }
+
+  std::vector<std::uint8_t> data(size);
+  input.read((char*)data.data(), size);
+
+  auto rom_hash = AOTHashROM(data.data(), size);
+  ROM rom {std::move(data)};
+  auto blocks = FindBlocks(rom);
+
+  auto file = std::fopen(argv[2], "w");
+  if (file == nullptr) {
+    std::printf("Failed to open output: %s\n", argv[2]);
+    return -1;
+  }
+
+  std::fprintf(file, "// Generated by ReBoyAOT from %s, do not edit.\n\n", argv[1]);
+  std::fprintf(file, "#include \"aot.hpp\"\n\n");
+
+  for (auto& block : blocks)
+    EmitBlock(file, block);
+
+  std::fprintf(file, "static AOTBlock const kBlocks[] = {\n");
+  for (auto& block : blocks) {
+    std::fprintf(file, "  { 0x%02X, 0x%04X, &Block_%02X_%04X },\n",
+      block.bank, block.address, block.bank, block.address);
+  }
+  std::fprintf(file, "};\n\n");
+
+  std::fprintf(file, "AOT_EXPORT AOTModuleInfo const reboy_aot_module = {\n");
+  std::fprintf(file, "  kAOTVersion, 0x%08X, %zu, kBlocks\n};\n", rom_hash, blocks.size());
+  std::fclose(file);
+
+  std::printf("Generated %zu blocks. Build the module with e.g.:\n", blocks.size());
+  std::printf("  c++ -O2 -shared -fPIC -I source/core/cpu/aot %s -o %s.so\n", argv[2], argv[1]);
+  return 0;
+}
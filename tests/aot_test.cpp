@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+// Round trip through the ahead-of-time recompiler: generates C++ for a test
+// ROM with ReBoyAOT, builds it into a module and checks that the precompiled
+// backend runs it exactly like the interpreter. Also checks that modules for
+// a different ROM or of a different version are rejected.
+//
+// Usage: aot_test <ReBoyAOT> <C++ compiler> <directory of aot.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "core/cpu/aot/aot_module.hpp"
+#include "frame_hash.hpp"
+#include "test_rom.hpp"
+
+static constexpr int kFrames = 300;
+
+static auto Run(std::string const& command) -> bool {
+  std::printf("%s\n", command.c_str());
+  std::fflush(stdout);
+  return std::system(command.c_str()) == 0;
+}
+
+static auto ReadText(std::string const& path) -> std::string {
+  std::ifstream file{path};
+  std::stringstream text;
+  text << file.rdbuf();
+  return text.str();
+}
+
+static auto WriteText(std::string const& path, std::string const& text) -> bool {
+  std::ofstream file{path};
+  file << text;
+  return file.good();
+}
+
+/// Loads a ROM into a new GameBoy, without a save file from previous runs.
+static auto Load(std::string const& rom_path) -> std::unique_ptr<GameBoy> {
+  std::remove((rom_path + ".sav").c_str());
+  auto gb = std::make_unique<GameBoy>();
+  if (!gb->LoadBootROM("aot_test_boot.bin") || !gb->LoadGame(rom_path))
+    return nullptr;
+  return gb;
+}
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::puts("Usage: aot_test <ReBoyAOT> <C++ compiler> <directory of aot.hpp>");
+    return 1;
+  }
+
+  std::string aot_tool = argv[1];
+  std::string compiler = argv[2];
+  std::string include_dir = argv[3];
+  auto Compile = [&](std::string const& source, std::string const& module) {
+    return Run("\"" + compiler + "\" -std=c++17 -O1 -shared -fPIC -I \"" + include_dir + "\" " + source + " -o " + module);
+  };
+
+  if (!WriteFile("aot_test_boot.bin", BuildTestBootROM()) ||
+      !WriteFile("aot_test.gb", BuildTestROM(4321)) ||
+      !WriteFile("aot_test_other.gb", BuildTestROM(8765))) {
+    std::puts("Cannot write the test ROMs");
+    return 1;
+  }
+
+  if (!Run("\"" + aot_tool + "\" aot_test.gb aot_test.cpp") ||
+      !Compile("aot_test.cpp", "aot_test.so")) {
+    std::puts("Cannot generate the AOT module");
+    return 1;
+  }
+
+  int failures = 0;
+
+  // The module must provide code for the cartridge entry point.
+  AOTModule module;
+  if (!module.Load("aot_test.so") || module.Find(0, 0x0100) == nullptr) {
+    std::puts("FAIL: module has no code for the cartridge entry point");
+    failures++;
+  }
+
+  // Round trip: the precompiled backend must match the interpreter.
+  {
+    auto reference = Load("aot_test.gb");
+    if (!reference) {
+      std::puts("Cannot load aot_test.gb");
+      return 1;
+    }
+    auto expected = HashFrames(*reference, kFrames);
+    reference.reset();
+
+    auto gb = Load("aot_test.gb");
+    if (!gb->LoadAOTModule("aot_test.so")) {
+      std::puts("FAIL: module for aot_test.gb was rejected");
+      failures++;
+    } else {
+      gb->SetCPUBackend(CPUBackend::Precompiled);
+      auto hashes = HashFrames(*gb, kFrames);
+      for (int frame = 0; frame < kFrames; frame++) {
+        if (hashes[frame] != expected[frame]) {
+          std::printf("FAIL: frame %d differs from the interpreter\n", frame);
+          failures++;
+          break;
+        }
+      }
+    }
+  }
+
+  // A module must only be accepted for the ROM it was generated from.
+  {
+    auto gb = Load("aot_test_other.gb");
+    if (!gb || gb->LoadAOTModule("aot_test.so")) {
+      std::puts("FAIL: module was accepted for a different ROM");
+      failures++;
+    }
+  }
+
+  // Modules built against another version of aot.hpp must be rejected.
+  {
+    auto source = ReadText("aot_test.cpp");
+    auto position = source.find("kAOTVersion,");
+    if (position == std::string::npos) {
+      std::puts("Cannot find the version in aot_test.cpp");
+      return 1;
+    }
+    source.replace(position, 12, "kAOTVersion + 1,");
+
+    if (!WriteText("aot_test_version.cpp", source) ||
+        !Compile("aot_test_version.cpp", "aot_test_version.so")) {
+      std::puts("Cannot build the outdated AOT module");
+      return 1;
+    }
+
+    auto gb = Load("aot_test.gb");
+    if (!gb || gb->LoadAOTModule("aot_test_version.so")) {
+      std::puts("FAIL: module of a different version was accepted");
+      failures++;
+    }
+  }
+
+  std::remove("aot_test.gb.sav");
+  std::remove("aot_test_other.gb.sav");
+  return failures == 0 ? 0 : 1;
+}
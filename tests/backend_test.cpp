@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+// Headless regression test: runs generated test ROMs on every CPU backend
+// and compares a hash of the frame buffer, RAM, VRAM, OAM and the time
+// after each frame against the interpreter. Also checks that stopping on
+// VBlank, on breakpoints and on the target time works on every backend.
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "backends.hpp"
+#include "frame_hash.hpp"
+#include "test_rom.hpp"
+
+static constexpr int kFrames = 300;
+static constexpr unsigned int kSeeds[] { 1234, 5678 };
+static constexpr int kCyclesPerFrame = 70224;
+static constexpr int kMaxInstructionCycles = 24;
+
+/// Entry of the VBlank handler, which the test ROM enters once per frame.
+static constexpr std::uint16_t kVBlankVector = 0x0040;
+
+/// Never executed by the test ROM.
+static constexpr std::uint16_t kUnusedAddress = 0x0008;
+
+static auto RunFrames(std::string const& rom_path, CPUBackend backend) -> std::vector<std::uint64_t> {
+  std::vector<std::uint64_t> hashes;
+
+  // The MBC3 keeps its RAM in a save file, which must not carry over.
+  std::remove((rom_path + ".sav").c_str());
+
+  auto gb = std::make_unique<GameBoy>();
+  if (gb->LoadBootROM("test_boot.bin") && gb->LoadGame(rom_path)) {
+    gb->SetCPUBackend(backend);
+    hashes = HashFrames(*gb, kFrames);
+  }
+
+  gb.reset();
+  std::remove((rom_path + ".sav").c_str());
+  return hashes;
+}
+
+/// One return of RunUntil() and friends.
+struct Stop {
+  GameBoy::StopReason reason;
+  std::uint64_t timestamp;
+  std::uint16_t pc;
+
+  auto operator==(Stop const& other) const -> bool {
+    return reason == other.reason && timestamp == other.timestamp && pc == other.pc;
+  }
+};
+
+/// Runs the ROM with VBlank stops, breakpoints and odd cycle counts and
+/// returns where each run stopped. Returns an empty list if the stops
+/// break the rules of their stop reason.
+static auto RunStops(std::string const& rom_path, CPUBackend backend, bool with_breakpoint) -> std::vector<Stop> {
+  std::vector<Stop> stops;
+  std::string error;
+
+  std::remove((rom_path + ".sav").c_str());
+
+  auto gb = std::make_unique<GameBoy>();
+  if (!gb->LoadBootROM("test_boot.bin") || !gb->LoadGame(rom_path))
+    return {};
+  gb->SetCPUBackend(backend);
+
+  auto Record = [&](GameBoy::StopReason reason) {
+    stops.push_back({reason, gb->GetTimestampNow(), gb->GetPC()});
+    return stops.back();
+  };
+
+  // Each frame must stop at VBlank, at most one instruction late.
+  gb->SetStopOnVBlank(true);
+  for (int i = 0; i < 20 && error.empty(); i++) {
+    auto stop = Record(gb->RunFrames(1));
+    auto vblank = stops[0].timestamp + std::uint64_t(i) * kCyclesPerFrame;
+    if (stop.reason != GameBoy::StopReason::VBlank) {
+      error = "did not stop on VBlank";
+    } else if (stop.timestamp + kMaxInstructionCycles <= vblank || stop.timestamp >= vblank + kMaxInstructionCycles) {
+      error = "VBlank stops are not a frame apart";
+    }
+  }
+  gb->SetStopOnVBlank(false);
+
+  // A breakpoint must stop before the instruction at its address.
+  gb->AddBreakpoint(kVBlankVector);
+  for (int i = 0; i < 20 && error.empty(); i++) {
+    auto stop = Record(gb->RunCycles(2 * kCyclesPerFrame));
+    if (stop.reason != GameBoy::StopReason::Breakpoint || stop.pc != kVBlankVector) {
+      error = "did not stop at the VBlank handler";
+    }
+  }
+  gb->ClearBreakpoints();
+
+  // Breakpoints that are never hit must not change where runs stop.
+  if (with_breakpoint) {
+    gb->AddBreakpoint(kUnusedAddress);
+  }
+  for (int i = 0; i < 50 && error.empty(); i++) {
+    auto stop = Record(gb->RunCycles(1000 + i * 4567));
+    if (stop.reason != GameBoy::StopReason::Target) {
+      error = "did not stop at the target";
+    }
+  }
+
+  gb.reset();
+  std::remove((rom_path + ".sav").c_str());
+
+  if (!error.empty()) {
+    std::printf("%s, %s: %s after %zu stops\n", rom_path.c_str(), GetBackendName(backend), error.c_str(), stops.size());
+    return {};
+  }
+  return stops;
+}
+
+int main() {
+  int failures = 0;
+
+  if (!WriteFile("test_boot.bin", BuildTestBootROM())) {
+    std::puts("Cannot write the boot ROM");
+    return 1;
+  }
+
+  for (auto seed : kSeeds) {
+    auto rom_path = "test_" + std::to_string(seed) + ".gb";
+    if (!WriteFile(rom_path, BuildTestROM(seed))) {
+      std::printf("Cannot write %s\n", rom_path.c_str());
+      return 1;
+    }
+
+    auto reference = RunFrames(rom_path, CPUBackend::Interpreter);
+    if (reference.size() != kFrames) {
+      std::printf("%s: failed to load\n", rom_path.c_str());
+      return 1;
+    }
+
+    auto reference_stops = RunStops(rom_path, CPUBackend::Interpreter, false);
+    if (reference_stops.empty()) {
+      failures++;
+    }
+
+    for (auto backend : kAllBackends) {
+      for (auto with_breakpoint : {false, true}) {
+        auto stops = RunStops(rom_path, backend, with_breakpoint);
+        if (!stops.empty() && stops != reference_stops) {
+          std::printf("%s, %s: stops differ from the interpreter%s\n", rom_path.c_str(), GetBackendName(backend),
+                      with_breakpoint ? " with a breakpoint set" : "");
+          failures++;
+        } else if (stops.empty()) {
+          failures++;
+        }
+      }
+
+      auto hashes = RunFrames(rom_path, backend);
+      if (hashes.size() != reference.size()) {
+        std::printf("%s, %s: failed to load\n", rom_path.c_str(), GetBackendName(backend));
+        failures++;
+        continue;
+      }
+      for (int frame = 0; frame < kFrames; frame++) {
+        if (hashes[frame] != reference[frame]) {
+          std::printf("%s, %s: frame %d differs from the interpreter\n", rom_path.c_str(), GetBackendName(backend), frame);
+          failures++;
+          break;
+        }
+      }
+    }
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include "core/cpu/cpu.hpp"
+
+static constexpr CPUBackend kAllBackends[] {
+  CPUBackend::Interpreter,
+  CPUBackend::ThreadedInterpreter,
+  CPUBackend::CachedInterpreter,
+  CPUBackend::Recompiler,
+  CPUBackend::Precompiled
+};
+
+inline auto GetBackendName(CPUBackend backend) -> char const* {
+  switch (backend) {
+    case CPUBackend::Interpreter: return "Interpreter";
+    case CPUBackend::ThreadedInterpreter: return "ThreadedInterpreter";
+    case CPUBackend::CachedInterpreter: return "CachedInterpreter";
+    case CPUBackend::Recompiler: return "Recompiler";
+    case CPUBackend::Precompiled: return "Precompiled";
+  }
+  return "?";
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+// Runs a small program on CPU<MemoryBase>, which the emulator itself never
+// uses, and checks that every backend agrees with the interpreter on memory,
+// registers and cycles, including an interrupt raised while halted.
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "flat_bus.hpp"
+
+static const std::initializer_list<std::uint8_t> kProgram {
+  0x31, 0xFE, 0xFF, // 0000: LD SP, $FFFE
+  0x21, 0x00, 0xC0, // 0003: LD HL, $C000
+  0x06, 0x40,       // 0006: LD B, $40
+  0x3E, 0x01,       // 0008: LD A, $01
+  0x22,             // 000A: LD (HL+), A
+  0xCB, 0x27,       // 000B: SLA A
+  0xCE, 0x03,       // 000D: ADC A, $03
+  0xCD, 0x30, 0x00, // 000F: CALL $0030
+  0x05,             // 0012: DEC B
+  0x20, 0xF5,       // 0013: JR NZ, $000A
+  0xFB,             // 0015: EI
+  0x76,             // 0016: HALT
+  0xF5,             // 0017: PUSH AF
+  0xD1,             // 0018: POP DE
+  0x7A,             // 0019: LD A, D
+  0xEA, 0x00, 0xC1, // 001A: LD ($C100), A
+  0x7B,             // 001D: LD A, E
+  0xEA, 0x01, 0xC1, // 001E: LD ($C101), A
+  0xF3,             // 0021: DI
+  0x76,             // 0022: HALT
+};
+
+static const std::initializer_list<std::uint8_t> kSubroutine {
+  0xC5,             // 0030: PUSH BC
+  0x47,             // 0031: LD B, A
+  0xCB, 0x38,       // 0032: SRL B
+  0xA8,             // 0034: XOR B
+  0xC1,             // 0035: POP BC
+  0xC9              // 0036: RET
+};
+
+static const std::initializer_list<std::uint8_t> kHandler {
+  0x3E, 0x5A,       // 0040: LD A, $5A
+  0xEA, 0x02, 0xC1, // 0042: LD ($C102), A
+  0xD9              // 0045: RETI
+};
+
+struct Result {
+  std::uint8_t ram[0x200];
+  std::uint16_t pc;
+  std::uint64_t cycles;
+};
+
+static auto Run(CPUBackend backend, Result& result) -> bool {
+  auto bus = std::make_unique<FlatBus>(kProgram);
+  std::copy(kSubroutine.begin(), kSubroutine.end(), &bus->data[0x30]);
+  std::copy(kHandler.begin(), kHandler.end(), &bus->data[0x40]);
+
+  CPU<MemoryBase> cpu{bus.get()};
+  cpu.SetBackend(backend);
+
+  if (!RunUntilHalted(cpu, *bus, 100000))
+    return false;
+
+  // Same sequence as the interrupt controller.
+  cpu.interrupt_requested = true;
+  cpu.RaiseIRQ(0x40);
+  cpu.interrupt_requested = false;
+
+  if (!RunUntilHalted(cpu, *bus, 100000))
+    return false;
+
+  std::memcpy(result.ram, &bus->data[0xC000], sizeof(result.ram));
+  result.pc = cpu.GetPC();
+  result.cycles = bus->GetTimestampNow();
+  return true;
+}
+
+int main() {
+  int failures = 0;
+  Result reference;
+
+  if (!Run(CPUBackend::Interpreter, reference) || reference.pc != 0x0023 || reference.ram[0x102] != 0x5A) {
+    std::puts("Interpreter: program did not run to completion");
+    return 1;
+  }
+
+  for (auto backend : kAllBackends) {
+    Result result;
+    auto name = GetBackendName(backend);
+
+    if (!Run(backend, result)) {
+      std::printf("%s: did not halt\n", name);
+      failures++;
+    } else if (std::memcmp(result.ram, reference.ram, sizeof(result.ram)) != 0) {
+      std::printf("%s: memory differs from the interpreter\n", name);
+      failures++;
+    } else if (result.pc != reference.pc || result.cycles != reference.cycles) {
+      std::printf("%s: PC %04X after %llu cycles, expected %04X after %llu cycles\n", name,
+        result.pc, (unsigned long long)result.cycles, reference.pc, (unsigned long long)reference.cycles);
+      failures++;
+    }
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+// Checks the lazily computed flags of all ALU, INC/DEC, rotate and shift
+// instructions against a straightforward eager implementation, for every
+// combination of operands and carry.
+
+#include <cstdio>
+#include <memory>
+
+#include "flat_bus.hpp"
+
+enum class Op {
+  ADD, ADC, SUB, SBC, AND, XOR, OR, CP,
+  INC, DEC, CPL,
+  RLCA, RRCA, RLA, RRA,
+  RLC, RRC, RL, RR, SLA, SRA, SWAP, SRL,
+  BIT0, BIT7
+};
+
+struct OpInfo {
+  Op op;
+  char const* name;
+  std::uint8_t code[2];
+  bool uses_b;
+};
+
+// Operand B lives in register D. Single byte opcodes are padded with a NOP.
+static constexpr OpInfo kOps[] {
+  { Op::ADD,  "ADD",  {0x82, 0x00}, true },
+  { Op::ADC,  "ADC",  {0x8A, 0x00}, true },
+  { Op::SUB,  "SUB",  {0x92, 0x00}, true },
+  { Op::SBC,  "SBC",  {0x9A, 0x00}, true },
+  { Op::AND,  "AND",  {0xA2, 0x00}, true },
+  { Op::XOR,  "XOR",  {0xAA, 0x00}, true },
+  { Op::OR,   "OR",   {0xB2, 0x00}, true },
+  { Op::CP,   "CP",   {0xBA, 0x00}, true },
+  { Op::INC,  "INC",  {0x3C, 0x00}, false },
+  { Op::DEC,  "DEC",  {0x3D, 0x00}, false },
+  { Op::CPL,  "CPL",  {0x2F, 0x00}, false },
+  { Op::RLCA, "RLCA", {0x07, 0x00}, false },
+  { Op::RRCA, "RRCA", {0x0F, 0x00}, false },
+  { Op::RLA,  "RLA",  {0x17, 0x00}, false },
+  { Op::RRA,  "RRA",  {0x1F, 0x00}, false },
+  { Op::RLC,  "RLC",  {0xCB, 0x07}, false },
+  { Op::RRC,  "RRC",  {0xCB, 0x0F}, false },
+  { Op::RL,   "RL",   {0xCB, 0x17}, false },
+  { Op::RR,   "RR",   {0xCB, 0x1F}, false },
+  { Op::SLA,  "SLA",  {0xCB, 0x27}, false },
+  { Op::SRA,  "SRA",  {0xCB, 0x2F}, false },
+  { Op::SWAP, "SWAP", {0xCB, 0x37}, false },
+  { Op::SRL,  "SRL",  {0xCB, 0x3F}, false },
+  { Op::BIT0, "BIT0", {0xCB, 0x47}, false },
+  { Op::BIT7, "BIT7", {0xCB, 0x7F}, false }
+};
+
+static constexpr std::uint8_t kZ = 0x80;
+static constexpr std::uint8_t kN = 0x40;
+static constexpr std::uint8_t kH = 0x20;
+static constexpr std::uint8_t kC = 0x10;
+
+/// Result in the high byte, flags in the low byte. Z, N and H are clear
+/// before the instruction, C is set to `carry`.
+static auto Reference(Op op, int a, int b, int carry) -> std::uint16_t {
+  int r = a;
+  std::uint8_t f = 0;
+  bool z_from_result = true;
+
+  const auto Add = [&](int c) {
+    r = a + b + c;
+    if ((a & 0xF) + (b & 0xF) + c > 0xF) f |= kH;
+    if (r > 0xFF) f |= kC;
+  };
+
+  const auto Sub = [&](int c) {
+    r = a - b - c;
+    f |= kN;
+    if ((a & 0xF) < (b & 0xF) + c) f |= kH;
+    if (a < b + c) f |= kC;
+  };
+
+  const auto Carry = [&](int bit) {
+    if (bit) f |= kC;
+  };
+
+  switch (op) {
+    case Op::ADD: Add(0); break;
+    case Op::ADC: Add(carry); break;
+    case Op::SUB: Sub(0); break;
+    case Op::SBC: Sub(carry); break;
+    case Op::AND: r = a & b; f |= kH; break;
+    case Op::XOR: r = a ^ b; break;
+    case Op::OR:  r = a | b; break;
+    case Op::CP:
+      Sub(0);
+      if ((r & 0xFF) == 0) f |= kZ;
+      return (a << 8) | f;
+    case Op::INC:
+      r = a + 1;
+      if ((a & 0xF) == 0xF) f |= kH;
+      Carry(carry);
+      break;
+    case Op::DEC:
+      r = a - 1;
+      f |= kN;
+      if ((a & 0xF) == 0) f |= kH;
+      Carry(carry);
+      break;
+    case Op::CPL:
+      r = ~a;
+      f |= kN | kH;
+      Carry(carry);
+      z_from_result = false;
+      break;
+    case Op::RLCA: case Op::RLC: r = (a << 1) | (a >> 7); Carry(a >> 7); break;
+    case Op::RRCA: case Op::RRC: r = (a >> 1) | (a << 7); Carry(a & 1); break;
+    case Op::RLA:  case Op::RL:  r = (a << 1) | carry; Carry(a >> 7); break;
+    case Op::RRA:  case Op::RR:  r = (a >> 1) | (carry << 7); Carry(a & 1); break;
+    case Op::SLA:  r = a << 1; Carry(a >> 7); break;
+    case Op::SRA:  r = (a >> 1) | (a & 0x80); Carry(a & 1); break;
+    case Op::SWAP: r = (a >> 4) | (a << 4); break;
+    case Op::SRL:  r = a >> 1; Carry(a & 1); break;
+    case Op::BIT0: case Op::BIT7: {
+      auto bit = op == Op::BIT0 ? 0 : 7;
+      f |= kH;
+      if (~a & (1 << bit)) f |= kZ;
+      Carry(carry);
+      return (a << 8) | f;
+    }
+  }
+
+  // The accumulator rotates always clear Z.
+  if (op == Op::RLCA || op == Op::RRCA || op == Op::RLA || op == Op::RRA)
+    z_from_result = false;
+  if (z_from_result && (r & 0xFF) == 0)
+    f |= kZ;
+  return ((r & 0xFF) << 8) | f;
+}
+
+/// Runs `op` for all values of A, and `count` values of B from `b`.
+/// Stores A and F for each combination to 0x8000 onwards.
+static auto MakeProgram(OpInfo const& op, int b, int count, int carry) -> std::unique_ptr<FlatBus> {
+  return std::make_unique<FlatBus>(std::initializer_list<std::uint8_t>{
+    0x31, 0xFE, 0xFF,             // 0000: LD SP, $FFFE
+    0x21, 0x00, 0x80,             // 0003: LD HL, $8000
+    0x16, std::uint8_t(b),        // 0006: LD D, b
+    0x1E, 0x00,                   // 0008: LD E, $00
+    0x7B,                         // 000A: LD A, E
+    0x37,                         // 000B: SCF
+    std::uint8_t(carry ? 0x00 : 0x3F), // 000C: NOP or CCF
+    op.code[0], op.code[1],       // 000D: op
+    0x22,                         // 000F: LD (HL+), A
+    0xF5,                         // 0010: PUSH AF
+    0xC1,                         // 0011: POP BC
+    0x71,                         // 0012: LD (HL), C
+    0x23,                         // 0013: INC HL
+    0x1C,                         // 0014: INC E
+    0x20, 0xF3,                   // 0015: JR NZ, $000A
+    0x14,                         // 0017: INC D
+    0x7A,                         // 0018: LD A, D
+    0xFE, std::uint8_t(b + count),// 0019: CP b + count
+    0x20, 0xEB,                   // 001B: JR NZ, $0008
+    0x76                          // 001D: HALT
+  });
+}
+
+int main() {
+  // Results for 32 values of B fill 0x8000 - 0xBFFF.
+  static constexpr int kChunk = 32;
+  int failures = 0;
+
+  for (auto backend : kAllBackends) {
+    for (auto const& op : kOps) {
+      for (int carry = 0; carry <= 1; carry++) {
+        for (int b0 = 0; b0 < 256; b0 += kChunk) {
+          auto count = op.uses_b ? kChunk : 1;
+          auto bus = MakeProgram(op, b0, count, carry);
+          CPU<MemoryBase> cpu{bus.get()};
+          cpu.SetBackend(backend);
+
+          if (!RunUntilHalted(cpu, *bus, 100000000)) {
+            std::printf("%s, %s: did not halt\n", GetBackendName(backend), op.name);
+            return 1;
+          }
+
+          int errors = 0;
+          for (int b = b0; b < b0 + count; b++) {
+            for (int a = 0; a < 256; a++) {
+              auto address = 0x8000 + ((b - b0) * 256 + a) * 2;
+              auto expected = Reference(op.op, a, b, carry);
+              auto actual = std::uint16_t((bus->data[address] << 8) | bus->data[address + 1]);
+              if (actual != expected && errors++ == 0) {
+                std::printf("%s, %s A=%02X B=%02X C=%d: got A=%02X F=%02X, expected A=%02X F=%02X\n",
+                  GetBackendName(backend), op.name, a, b, carry,
+                  actual >> 8, actual & 0xFF, expected >> 8, expected & 0xFF);
+              }
+            }
+          }
+          failures += errors;
+
+          if (!op.uses_b)
+            break;
+        }
+      }
+    }
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+
+#include "backends.hpp"
+#include "core/cpu/cpu.hpp"
+
+/// 64 KiB of plain memory behind the virtual bus interface, with two ROM
+/// banks at 0x0000 - 0x7FFF that ignore writes. Nothing is ever scheduled.
+struct FlatBus final : MemoryBase {
+  FlatBus(std::initializer_list<std::uint8_t> program, std::uint16_t address = 0) {
+    std::copy(program.begin(), program.end(), &data[address]);
+  }
+
+  auto ReadByte(std::uint16_t address) -> std::uint8_t override {
+    Tick();
+    return data[address];
+  }
+
+  void WriteByte(std::uint16_t address, std::uint8_t value) override {
+    Tick();
+    if (address >= 0x8000)
+      data[address] = value;
+  }
+
+  auto GetROM1Bank() -> std::uint8_t override { return 1; }
+
+  void Tick() override { timestamp += 4; }
+
+  auto GetCodeBank(std::uint16_t address) -> int override {
+    return address < 0x8000 ? address >> 14 : -1;
+  }
+
+  auto ReadCode(std::uint16_t address) -> std::uint8_t override {
+    return data[address];
+  }
+
+  auto GetTimestampNow() const -> std::uint64_t override { return timestamp; }
+
+  auto GetNextEventTimestamp() const -> std::uint64_t override {
+    return std::numeric_limits<std::uint64_t>::max();
+  }
+
+  std::uint8_t data[0x10000] {};
+  std::uint64_t timestamp = 0;
+};
+
+/// Runs the CPU until it halts or `max_cycles` passed.
+/// Returns false if it did not halt in time.
+inline auto RunUntilHalted(CPU<MemoryBase>& cpu, FlatBus& bus, std::uint64_t max_cycles) -> bool {
+  auto deadline = bus.GetTimestampNow() + max_cycles;
+  while (!cpu.IsHalted()) {
+    if (bus.GetTimestampNow() >= deadline)
+      return false;
+    cpu.Run(deadline);
+  }
+  return true;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "core/gameboy.hpp"
+
+/// FNV-1a hash of everything a frame leaves behind.
+struct FrameHash {
+  std::uint64_t value = 14695981039346656037ull;
+
+  void Add(std::uint8_t byte) {
+    value = (value ^ byte) * 1099511628211ull;
+  }
+
+  void Add(void const* data, std::size_t size) {
+    for (std::size_t i = 0; i < size; i++)
+      Add(static_cast<std::uint8_t const*>(data)[i]);
+  }
+
+  void AddMemory(GameBoy& gb, int begin, int end) {
+    for (int address = begin; address < end; address++)
+      Add(gb.Peek(std::uint16_t(address)));
+  }
+};
+
+/// Runs `frames` frames and hashes the frame buffer, VRAM, WRAM, OAM, HRAM
+/// and the cycles taken after each of them.
+inline auto HashFrames(GameBoy& gb, int frames) -> std::vector<std::uint64_t> {
+  static std::uint32_t buffer[160 * 144];
+  std::vector<std::uint64_t> hashes;
+
+  for (int frame = 0; frame < frames; frame++) {
+    FrameHash hash;
+    auto timestamp = gb.GetTimestampNow();
+
+    gb.Frame(buffer);
+    timestamp = gb.GetTimestampNow() - timestamp;
+    hash.Add(buffer, sizeof(buffer));
+    hash.Add(&timestamp, sizeof(timestamp));
+    hash.AddMemory(gb, 0x8000, 0xA000);
+    hash.AddMemory(gb, 0xC000, 0xE000);
+    hash.AddMemory(gb, 0xFE00, 0xFEA0);
+    hash.AddMemory(gb, 0xFF80, 0xFFFF);
+    hashes.push_back(hash.value);
+  }
+
+  return hashes;
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+// Headless regression test for the frame buffer: runs a generated test ROM
+// frame by frame next to a reference that renders ARGB8888 during emulation,
+// and checks threaded rendering, the other pixel formats and frame skipping
+// against it.
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "core/gameboy.hpp"
+#include "test_rom.hpp"
+
+static constexpr int kFrames = 300;
+static constexpr int kPixels = 160 * 144;
+
+/// Skips the first two out of every three frames.
+static constexpr int kSkip = 2;
+static constexpr int kSkipPeriod = 3;
+
+/// Draws nothing before this frame.
+static constexpr std::uint64_t kSkipUntil = 50;
+
+/// Runs a ROM up to the next VBlank at a time, into its own frame buffer.
+struct Instance {
+  std::unique_ptr<GameBoy> gb = std::make_unique<GameBoy>();
+  std::uint32_t argb8888[kPixels] {};
+  std::uint16_t rgb565[kPixels] {};
+  std::uint8_t gray8[kPixels] {};
+  std::uint8_t shade2[kPixels / 4] {};
+
+  auto Load(std::string const& rom_path) -> bool {
+    std::remove((rom_path + ".sav").c_str());
+    if (!gb->LoadBootROM("render_test_boot.bin") || !gb->LoadGame(rom_path))
+      return false;
+    gb->SetStopOnVBlank(true);
+    return true;
+  }
+
+  auto RunFrame() -> bool {
+    return gb->RunFrames(1) == GameBoy::StopReason::VBlank;
+  }
+};
+
+static auto GetShade(std::uint32_t color) -> int {
+  for (int shade = 0; shade < 4; shade++) {
+    if (Renderer::kColorPalette[shade] == color)
+      return shade;
+  }
+  return -1;
+}
+
+/// Returns the first pixel format whose frame does not show the same shades
+/// as the ARGB8888 frame, or nullptr.
+static auto FindFormatMismatch(std::uint32_t const* argb8888, std::uint16_t const* rgb565,
+                               std::uint8_t const* gray8, std::uint8_t const* shade2) -> char const* {
+  static constexpr std::uint16_t kColorsRGB565[4] { 0xFFFF, 0x630C, 0x2104, 0x0000 };
+  static constexpr std::uint8_t kColorsGray8[4] { 0xFF, 0x60, 0x20, 0x00 };
+
+  for (int i = 0; i < kPixels; i++) {
+    auto shade = GetShade(argb8888[i]);
+    if (shade < 0)
+      return "ARGB8888";
+    if (rgb565[i] != kColorsRGB565[shade])
+      return "RGB565";
+    if (gray8[i] != kColorsGray8[shade])
+      return "Gray8";
+    if (((shade2[i >> 2] >> ((i & 3) * 2)) & 3) != shade)
+      return "Shade2";
+  }
+  return nullptr;
+}
+
+static auto RunTest(std::string const& rom_path) -> int {
+  int failures = 0;
+
+  auto Fail = [&](char const* what, int frame) {
+    std::printf("%s: %s, frame %d\n", rom_path.c_str(), what, frame);
+    failures++;
+  };
+
+  // Each instance is heavy, so keep them off the stack.
+  auto reference = std::make_unique<Instance>();
+  auto threaded = std::make_unique<Instance>();
+  auto rgb565 = std::make_unique<Instance>();
+  auto gray8 = std::make_unique<Instance>();
+  auto shade2 = std::make_unique<Instance>();
+  auto skip = std::make_unique<Instance>();
+  auto skip_until = std::make_unique<Instance>();
+  Instance* instances[] { reference.get(), threaded.get(), rgb565.get(), gray8.get(), shade2.get(), skip.get(), skip_until.get() };
+
+  reference->gb->SetBuffer(reference->argb8888);
+  threaded->gb->SetBuffer(threaded->argb8888);
+  threaded->gb->SetThreadedRendering(true);
+  rgb565->gb->SetBuffer(rgb565->rgb565, PixelFormat::RGB565);
+  gray8->gb->SetBuffer(gray8->gray8, PixelFormat::Gray8);
+  shade2->gb->SetBuffer(shade2->shade2, PixelFormat::Shade2);
+  skip->gb->SetBuffer(skip->argb8888);
+  skip->gb->SetFrameSkip(kSkip, kSkipPeriod);
+  skip_until->gb->SetBuffer(skip_until->argb8888);
+  skip_until->gb->SkipFramesUntil(kSkipUntil);
+
+  // Loading resets into the first frame, which must see the frame skip.
+  for (auto instance : instances) {
+    if (!instance->Load(rom_path)) {
+      std::printf("Cannot load %s\n", rom_path.c_str());
+      return 1;
+    }
+  }
+
+  // The frame before the current one, as the threaded renderer shows it.
+  auto previous = std::make_unique<std::uint32_t[]>(kPixels);
+  bool previous_unchanged = false;
+
+  // The last frame that the frame skipping instances drew.
+  auto last_drawn = std::make_unique<std::uint32_t[]>(kPixels);
+  auto last_drawn_until = std::make_unique<std::uint32_t[]>(kPixels);
+  std::memset(last_drawn.get(), 0, kPixels * sizeof(std::uint32_t));
+  std::memset(last_drawn_until.get(), 0, kPixels * sizeof(std::uint32_t));
+
+  for (int frame = 0; frame < kFrames && failures == 0; frame++) {
+    for (auto instance : instances) {
+      if (!instance->RunFrame()) {
+        Fail("did not stop on VBlank", frame);
+      }
+    }
+
+    auto frame_number = reference->gb->GetFrameCount();
+    auto const& expected = reference->argb8888;
+    auto size = sizeof(expected);
+
+    // The render thread lags one run behind.
+    if (frame > 0 && std::memcmp(threaded->argb8888, previous.get(), size) != 0) {
+      Fail("threaded rendering differs from the frame before", frame);
+    }
+    if (frame > 0 && threaded->gb->IsFrameUnchanged() != previous_unchanged) {
+      Fail("threaded rendering reports the wrong IsFrameUnchanged()", frame);
+    }
+    std::memcpy(previous.get(), expected, size);
+    previous_unchanged = reference->gb->IsFrameUnchanged();
+
+    if (auto format = FindFormatMismatch(expected, rgb565->rgb565, gray8->gray8, shade2->shade2)) {
+      std::printf("%s: %s differs from ARGB8888\n", rom_path.c_str(), format);
+      Fail("pixel formats differ", frame);
+    }
+
+    if (int(frame_number % kSkipPeriod) >= kSkip) {
+      std::memcpy(last_drawn.get(), expected, size);
+    }
+    if (std::memcmp(skip->argb8888, last_drawn.get(), size) != 0) {
+      Fail("frame skip did not keep the last drawn frame", frame);
+    }
+
+    if (frame_number >= kSkipUntil) {
+      std::memcpy(last_drawn_until.get(), expected, size);
+    }
+    if (std::memcmp(skip_until->argb8888, last_drawn_until.get(), size) != 0) {
+      Fail("skipping until a frame did not keep the last drawn frame", frame);
+    }
+  }
+
+  threaded->gb->SetThreadedRendering(false);
+  std::remove((rom_path + ".sav").c_str());
+  return failures;
+}
+
+int main() {
+  if (!WriteFile("render_test_boot.bin", BuildTestBootROM()) ||
+      !WriteFile("render_test.gb", BuildTestROM(2468))) {
+    std::puts("Cannot write the test ROMs");
+    return 1;
+  }
+
+  return RunTest("render_test.gb") == 0 ? 0 : 1;
+}
@@ -0,0 +1,461 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#include <cassert>
+#include <fstream>
+#include <initializer_list>
+#include <map>
+#include <random>
+
+#include "test_rom.hpp"
+
+namespace {
+
+class Assembler {
+public:
+  Assembler(std::uint16_t base) : base(base) {}
+
+  auto Here() const -> std::uint16_t { return std::uint16_t(base + code.size()); }
+  auto GetCode() const -> std::vector<std::uint8_t> const& { return code; }
+
+  void Label(std::string const& name) { labels[name] = Here(); }
+
+  void Emit(std::initializer_list<int> bytes) {
+    for (auto byte : bytes)
+      code.push_back(std::uint8_t(byte));
+  }
+
+  void Emit(std::vector<std::uint8_t> const& bytes) {
+    code.insert(code.end(), bytes.begin(), bytes.end());
+  }
+
+  void EmitWord(int value) { Emit({value & 0xFF, (value >> 8) & 0xFF}); }
+
+  void EmitAbsolute(std::string const& label) {
+    fixups.push_back({false, code.size(), label});
+    EmitWord(0);
+  }
+
+  void EmitRelative(std::string const& label) {
+    fixups.push_back({true, code.size(), label});
+    Emit({0});
+  }
+
+  void Resolve() {
+    for (auto const& fixup : fixups) {
+      auto target = labels.at(fixup.label);
+      if (fixup.relative) {
+        auto offset = target - (base + int(fixup.offset) + 1);
+        assert(offset >= -128 && offset <= 127);
+        code[fixup.offset] = std::uint8_t(offset);
+      } else {
+        code[fixup.offset + 0] = std::uint8_t(target);
+        code[fixup.offset + 1] = std::uint8_t(target >> 8);
+      }
+    }
+  }
+
+  void PadTo(std::uint16_t address) {
+    while (Here() < address)
+      Emit({0x00});
+  }
+
+  void LoadA(int value) { Emit({0x3E, value}); }
+  void WriteIO(int reg, int value) { LoadA(value); Emit({0xE0, reg}); }
+  void Jump(std::string const& label) { Emit({0xC3}); EmitAbsolute(label); }
+  void Call(int address) { Emit({0xCD}); EmitWord(address); }
+  void JumpRelative(int opcode, std::string const& label) { Emit({opcode}); EmitRelative(label); }
+
+private:
+  struct Fixup {
+    bool relative;
+    std::size_t offset;
+    std::string label;
+  };
+
+  std::uint16_t base;
+  std::vector<std::uint8_t> code;
+  std::map<std::string, int> labels;
+  std::vector<Fixup> fixups;
+};
+
+class Generator {
+public:
+  Generator(unsigned int seed) : rng(seed) {}
+
+  auto Build() -> std::vector<std::uint8_t>;
+
+private:
+  static constexpr int kStackInFuzz = 0xDFEE;
+  static constexpr int kVarFrame = 0xC000;
+  static constexpr int kVarTimer = 0xC001;
+  static constexpr int kVarLog = 0xC002;
+
+  auto Random(int n) -> int { return int(rng() % unsigned(n)); }
+  auto Chance() -> double { return std::uniform_real_distribution<double>{}(rng); }
+
+  static auto IsExcluded(int opcode) -> bool;
+  void LoadPointer(Assembler& a, int opcode);
+  void FuzzInstruction(Assembler& a);
+  void FuzzInstructionCB(Assembler& a);
+  void Checkpoint(Assembler& a);
+  void FuzzSequence(Assembler& a, int length);
+  void FuzzBlock(Assembler& a, int length, std::string const& tag);
+  void BuildBank0(Assembler& a);
+
+  std::mt19937 rng;
+  int checkpoints = 0;
+};
+
+auto Generator::IsExcluded(int opcode) -> bool {
+  switch (opcode) {
+    // Unused opcodes
+    case 0xD3: case 0xDB: case 0xDD: case 0xE3: case 0xE4:
+    case 0xEB: case 0xEC: case 0xED: case 0xF4: case 0xFC: case 0xFD:
+    // Control flow, stack and interrupt enable, which are emitted on purpose
+    case 0x08: case 0x10: case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+    case 0x31: case 0x33: case 0x3B: case 0x76:
+    case 0xC0 ... 0xC5: case 0xC7 ... 0xCD: case 0xCF:
+    case 0xD0 ... 0xD2: case 0xD4: case 0xD5: case 0xD7 ... 0xDA: case 0xDC: case 0xDF:
+    case 0xE1: case 0xE5: case 0xE7: case 0xE8: case 0xE9: case 0xEF:
+    case 0xF1: case 0xF3: case 0xF5: case 0xF7: case 0xF9: case 0xFB: case 0xFF:
+      return true;
+  }
+  return false;
+}
+
+/// Points BC, DE or HL (opcode 0x01, 0x11 or 0x21) into WRAM.
+void Generator::LoadPointer(Assembler& a, int opcode) {
+  a.Emit({opcode});
+  a.EmitWord(0xC200 + Random(0x600));
+}
+
+void Generator::FuzzInstruction(Assembler& a) {
+  int op;
+  do {
+    op = Random(256);
+  } while (IsExcluded(op));
+
+  if (op == 0x02 || op == 0x0A)
+    LoadPointer(a, 0x01);
+  if (op == 0x12 || op == 0x1A)
+    LoadPointer(a, 0x11);
+  if (op == 0x22 || op == 0x2A || op == 0x32 || op == 0x3A ||
+      op == 0x34 || op == 0x35 || op == 0x36 ||
+      (op >= 0x40 && op < 0x80 && ((op & 7) == 6 || (op & 0x38) == 0x30)) ||
+      (op >= 0x80 && op < 0xC0 && (op & 7) == 6)) {
+    LoadPointer(a, 0x21);
+  }
+
+  // LD (C), A and LD A, (C) access HRAM scratch space.
+  if (op == 0xE2 || op == 0xF2)
+    a.Emit({0x0E, 0x80 + Random(0x50)});
+  a.Emit({op});
+
+  switch (op) {
+    case 0xE0: case 0xF0:
+      a.Emit({0x80 + Random(0x50)});
+      break;
+    case 0xEA: case 0xFA:
+      a.EmitWord(0xC200 + Random(0x600));
+      break;
+    case 0x01: case 0x11: case 0x21:
+      a.EmitWord(Random(0x10000));
+      break;
+    case 0x06: case 0x0E: case 0x16: case 0x1E: case 0x26: case 0x2E: case 0x3E:
+    case 0xC6: case 0xCE: case 0xD6: case 0xDE: case 0xE6: case 0xEE: case 0xF6: case 0xFE:
+    case 0xF8: case 0x36:
+      a.Emit({Random(256)});
+      break;
+  }
+}
+
+void Generator::FuzzInstructionCB(Assembler& a) {
+  auto op = Random(256);
+  if ((op & 7) == 6)
+    LoadPointer(a, 0x21);
+  a.Emit({0xCB, op});
+}
+
+/// Saves all registers to D000 + 8 * n with interrupts disabled.
+void Generator::Checkpoint(Assembler& a) {
+  auto n = checkpoints++ % 250;
+  a.Emit({0xF3, 0x31});
+  a.EmitWord(0xD000 + 8 * (n + 1));
+  a.Emit({0xF5, 0xC5, 0xD5, 0xE5, 0x31});
+  a.EmitWord(kStackInFuzz);
+  a.Emit({0xFB});
+}
+
+void Generator::FuzzSequence(Assembler& a, int length) {
+  for (int i = 0; i < length; i++) {
+    auto r = Chance();
+    if (r < 0.12) {
+      FuzzInstructionCB(a);
+    } else if (r < 0.15) {
+      // PUSH rr, POP rr
+      a.Emit({0xC5 + 0x10 * Random(4), 0xC1 + 0x10 * Random(4)});
+    } else if (r < 0.17) {
+      // ADD SP, e
+      a.Emit({0xF3, 0xE8, Random(256), 0x31});
+      a.EmitWord(kStackInFuzz);
+      a.Emit({0xFB});
+    } else if (r < 0.19) {
+      // LD (nn), SP
+      a.Emit({0x08});
+      a.EmitWord(0xC200 + Random(0x600));
+    } else {
+      FuzzInstruction(a);
+    }
+  }
+}
+
+void Generator::FuzzBlock(Assembler& a, int length, std::string const& tag) {
+  static constexpr int kJumpRelative[] { 0x20, 0x28, 0x30, 0x38 };
+  static constexpr int kJump[] { 0xC2, 0xCA, 0xD2, 0xDA };
+  static constexpr int kCall[] { 0xC4, 0xCC, 0xD4, 0xDC };
+
+  for (int i = 0; i < length; i++) {
+    auto r = Chance();
+    if (r < 0.15) {
+      Assembler skipped{0};
+      FuzzSequence(skipped, 1 + Random(3));
+      a.Emit({kJumpRelative[Random(4)], int(skipped.GetCode().size())});
+      a.Emit(skipped.GetCode());
+    } else if (r < 0.2) {
+      auto opcode = kJump[Random(4)];
+      Assembler skipped{0};
+      FuzzSequence(skipped, 1 + Random(3));
+      a.Emit({opcode});
+      a.EmitWord(a.Here() + 2 + int(skipped.GetCode().size()));
+      a.Emit(skipped.GetCode());
+    } else if (r < 0.25) {
+      a.Emit({kCall[Random(4)]});
+      a.EmitAbsolute("sub_" + tag);
+    } else if (r < 0.3) {
+      Checkpoint(a);
+    } else {
+      FuzzSequence(a, 1);
+    }
+  }
+  Checkpoint(a);
+  a.Emit({0xC9});
+
+  // INC B; INC A; RET
+  a.Label("sub_" + tag);
+  a.Emit({0x04, 0x3C, 0xC9});
+}
+
+void Generator::BuildBank0(Assembler& a) {
+  a.PadTo(0x40); a.Jump("vblank");
+  a.PadTo(0x48); a.Jump("stat");
+  a.PadTo(0x50); a.Jump("timer");
+  a.PadTo(0x100); a.Emit({0x00}); a.Jump("main");
+  a.PadTo(0x150);
+
+  a.Label("main");
+  a.Emit({0x31}); a.EmitWord(0xDFF0);
+
+  // Copy bank 1 to VRAM.
+  a.LoadA(1); a.Emit({0xEA}); a.EmitWord(0x2000);
+  a.Emit({0x21}); a.EmitWord(0x4000);
+  a.Emit({0x11}); a.EmitWord(0x8000);
+  a.Emit({0x01}); a.EmitWord(0x2000);
+  a.Label("copy");
+  a.Emit({0x2A, 0x12, 0x13, 0x0B, 0x78, 0xB1});
+  a.JumpRelative(0x20, "copy");
+
+  // OBJs at C100 for OAM DMA.
+  a.Emit({0x21}); a.EmitWord(0xC100);
+  for (int i = 0; i < 40; i++) {
+    a.LoadA(Random(170)); a.Emit({0x22});
+    a.LoadA(Random(176)); a.Emit({0x22});
+    a.LoadA(Random(256)); a.Emit({0x22});
+    a.LoadA(Random(256) & 0xF0); a.Emit({0x22});
+  }
+  a.WriteIO(0x46, 0xC1);
+  a.WriteIO(0x47, 0xE4); a.WriteIO(0x48, 0xD2); a.WriteIO(0x49, 0x1B);
+  a.WriteIO(0x4A, 40); a.WriteIO(0x4B, 87);
+  a.WriteIO(0x40, 0xF3);
+  a.WriteIO(0x06, 0x80); a.WriteIO(0x07, 0x05);
+  a.WriteIO(0x41, 0x40); a.WriteIO(0x45, 0x20);
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0xE6, 0x0F});
+  a.JumpRelative(0x20, "nosnd");
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0xE0, 0x13, 0xE0, 0x1D});
+  a.WriteIO(0x14, 0x86); a.WriteIO(0x19, 0xC5); a.WriteIO(0x1E, 0xC4); a.WriteIO(0x23, 0xC0);
+  a.Label("nosnd");
+  a.WriteIO(0xFF, 0x07);
+
+  // Sound: channel 1 sweep and envelope, channel 2, channel 3 wave, channel 4 noise.
+  static constexpr int kSound[][2] {
+    {0x10, 0x15}, {0x11, 0x80}, {0x12, 0xF3}, {0x13, 0x40}, {0x14, 0x87},
+    {0x16, 0x40}, {0x17, 0xA5}, {0x18, 0x90}, {0x19, 0xC6},
+    {0x1A, 0x80}, {0x1B, 0x20}, {0x1C, 0x20}, {0x1D, 0x10}, {0x1E, 0xC5},
+    {0x20, 0x10}, {0x21, 0xC2}, {0x22, 0x35}, {0x23, 0x80}
+  };
+  for (auto const& write : kSound)
+    a.WriteIO(write[0], write[1]);
+  for (int i = 0; i < 16; i++)
+    a.WriteIO(0x30 + i, Random(256));
+
+  a.Emit({0x21}); a.EmitWord(0xC400);
+  a.Emit({0x7C, 0xEA}); a.EmitWord(kVarLog + 1);
+  a.Emit({0x7D, 0xEA}); a.EmitWord(kVarLog);
+
+  // LD A, n; INC A; LD (C901), A; ADD 0x11; RET
+  static constexpr int kSelfModifying[] { 0x3E, 0x00, 0x3C, 0xEA, 0x01, 0xC9, 0xC6, 0x11, 0xC9 };
+  a.Emit({0x21}); a.EmitWord(0xC900);
+  for (auto byte : kSelfModifying) {
+    a.LoadA(byte); a.Emit({0x22});
+  }
+
+  // LD A, 5; INC A; INC A; LD (FFF1), A; RET
+  static constexpr int kHRAMRoutine[] { 0x3E, 0x05, 0x3C, 0x3C, 0xEA, 0xF1, 0xFF, 0xC9 };
+  a.Emit({0x21}); a.EmitWord(0xFFF0);
+  for (auto byte : kHRAMRoutine) {
+    a.LoadA(byte); a.Emit({0x22});
+  }
+  a.Emit({0xFB});
+
+  a.Label("loop");
+  a.LoadA(2); a.Emit({0xEA}); a.EmitWord(0x2000); a.Emit({0x31}); a.EmitWord(0xDFF0); a.Call(0x4000);
+  a.LoadA(3); a.Emit({0xEA}); a.EmitWord(0x2100); a.Emit({0x31}); a.EmitWord(0xDFF0); a.Call(0x4000);
+
+  // Log DIV, TIMA, LY, STAT and IF to C400 - C7FF.
+  a.Emit({0xFA}); a.EmitWord(kVarLog); a.Emit({0x6F});
+  a.Emit({0xFA}); a.EmitWord(kVarLog + 1); a.Emit({0x67});
+  for (auto reg : {0x04, 0x05, 0x44, 0x41, 0x0F})
+    a.Emit({0xF0, reg, 0x22});
+  a.Emit({0x7C, 0xE6, 0x07, 0xF6, 0xC4, 0x67});
+  a.Emit({0x7C, 0xEA}); a.EmitWord(kVarLog + 1);
+  a.Emit({0x7D, 0xEA}); a.EmitWord(kVarLog);
+
+  a.Call(0xC900); a.Emit({0xEA}); a.EmitWord(0xC020);
+  a.Call(0xFFF0); a.Emit({0xEA}); a.EmitWord(0xC021);
+
+  // Wait for LY = 0x50, then for HBlank.
+  a.Label("wly");
+  a.Emit({0xF0, 0x44, 0xFE, 0x50});
+  a.JumpRelative(0x20, "wly");
+  a.Label("wst");
+  a.Emit({0xF0, 0x41, 0xE6, 0x03});
+  a.JumpRelative(0x20, "wst");
+
+  // Reset DIV and change the timer frequency every 8th frame, stop the
+  // timer every 16th frame and start it again 5 frames later.
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0xE6, 0x07});
+  a.JumpRelative(0x20, "nodiv");
+  a.Emit({0xE0, 0x04});
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0xE6, 0x18, 0x0F, 0x0F, 0x0F, 0xF6, 0x04, 0xE0, 0x07});
+  a.WriteIO(0x05, 0xF0);
+  a.Label("nodiv");
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0xE6, 0x0F});
+  a.JumpRelative(0x20, "nostop");
+  a.WriteIO(0x07, 0x00);
+  a.WriteIO(0x06, 0x33);
+  a.Label("nostop");
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0xE6, 0x0F, 0xFE, 0x05});
+  a.JumpRelative(0x20, "nostart");
+  a.WriteIO(0x07, 0x06);
+  a.Label("nostart");
+
+  a.Emit({0x76, 0x00});
+  a.Jump("loop");
+
+  a.Label("vblank");
+  a.Emit({0xF5, 0xE5, 0xC5});
+  a.Emit({0x21}); a.EmitWord(kVarFrame); a.Emit({0x34, 0x7E, 0x47});
+  a.Emit({0xF0, 0x43, 0x3C, 0xE0, 0x43});
+  a.Emit({0x78, 0xE6, 0x01, 0x4F, 0xF0, 0x42, 0x81, 0xE0, 0x42});
+  a.Emit({0x78, 0xE6, 0x3F, 0xC6, 0x07, 0xE0, 0x4B});
+  a.Emit({0x78, 0x0F, 0xE6, 0x7F, 0xE0, 0x4A});
+  a.Emit({0x78, 0x0F, 0x0F, 0x0F, 0x0F, 0xE6, 0x07, 0x4F, 0x06, 0x00, 0x21});
+  a.EmitAbsolute("lcdc_table");
+  a.Emit({0x09, 0x7E, 0xE0, 0x40});
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0xE6, 0x1F});
+  a.JumpRelative(0x20, "nopal");
+  a.Emit({0xF0, 0x47, 0x07, 0x07, 0xE0, 0x47, 0xF0, 0x48, 0x2F, 0xE0, 0x48});
+  a.Label("nopal");
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0x6F, 0x26, 0x80, 0x7E, 0x2F, 0x77});
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0x6F, 0x26, 0x99, 0x34});
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0x6F, 0x26, 0x9C, 0x35});
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0xE6, 0x03});
+  a.JumpRelative(0x20, "nodma");
+  a.WriteIO(0x46, 0xC1);
+  a.Label("nodma");
+  a.Emit({0x21}); a.EmitWord(0xFE00); a.Emit({0x34, 0x2C, 0x34, 0x2E, 0x10, 0x35, 0x2E, 0x21, 0x34});
+  a.Emit({0xFA}); a.EmitWord(kVarFrame); a.Emit({0xE6, 0x3F, 0x6F, 0x26, 0xFE, 0x34});
+  a.WriteIO(0x45, 0x20);
+  a.Emit({0xC1, 0xE1, 0xF1, 0xD9});
+
+  a.Label("stat");
+  a.Emit({0xF5});
+  a.Emit({0xF0, 0x43, 0xC6, 0x05, 0xE0, 0x43});
+  a.Emit({0xF0, 0x47, 0xEE, 0x0C, 0xE0, 0x47});
+  a.Emit({0xF0, 0x45, 0xC6, 0x18, 0xFE, 0x90});
+  a.JumpRelative(0x38, "lycok");
+  a.LoadA(0x08);
+  a.Label("lycok");
+  a.Emit({0xE0, 0x45});
+  a.Emit({0xF1, 0xD9});
+
+  a.Label("timer");
+  a.Emit({0xF5, 0xFA}); a.EmitWord(kVarTimer); a.Emit({0x3C, 0xEA}); a.EmitWord(kVarTimer); a.Emit({0xF1, 0xD9});
+
+  a.Label("lcdc_table");
+  a.Emit({0xF3, 0xE3, 0xB7, 0x97, 0xDB, 0x87, 0xFF, 0xD1});
+  a.Resolve();
+}
+
+auto Generator::Build() -> std::vector<std::uint8_t> {
+  std::vector<std::uint8_t> rom(0x10000, 0xFF);
+
+  for (int bank = 2; bank <= 3; bank++) {
+    Assembler a{0x4000};
+    FuzzBlock(a, 350, std::to_string(bank));
+    a.Resolve();
+    auto const& code = a.GetCode();
+    assert(code.size() < 0x4000);
+    std::copy(code.begin(), code.end(), rom.begin() + bank * 0x4000);
+  }
+
+  for (int i = 0; i < 0x4000; i++)
+    rom[0x4000 + i] = std::uint8_t(Random(256));
+
+  Assembler a{0};
+  BuildBank0(a);
+  auto const& code = a.GetCode();
+  assert(code.size() < 0x4000);
+  std::copy(code.begin(), code.end(), rom.begin());
+
+  // MBC3 + RAM + battery
+  rom[0x147] = 0x13;
+  return rom;
+}
+
+} // namespace
+
+auto BuildTestROM(unsigned int seed) -> std::vector<std::uint8_t> {
+  return Generator{seed}.Build();
+}
+
+auto BuildTestBootROM() -> std::vector<std::uint8_t> {
+  std::vector<std::uint8_t> boot(256, 0x00);
+
+  // LD A, 1; LDH (0x50), A
+  boot[0xFC] = 0x3E;
+  boot[0xFD] = 0x01;
+  boot[0xFE] = 0xE0;
+  boot[0xFF] = 0x50;
+  return boot;
+}
+
+auto WriteFile(std::string const& path, std::vector<std::uint8_t> const& data) -> bool {
+  std::ofstream file{path, std::ios::out | std::ios::binary};
+  file.write((char const*)data.data(), data.size());
+  return file.good();
+}
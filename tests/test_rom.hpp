@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2020 fleroviux
+ *
+ * Licensed under GPLv3 or any later version.
+ * Refer to the included LICENSE file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Builds a 64 KiB MBC3 test ROM from a random seed. Banks 2 and 3 hold
+/// random instruction streams that save their registers at checkpoints,
+/// bank 1 random data for VRAM. The main loop in bank 0 calls both banks,
+/// runs code from WRAM that modifies itself and code from HRAM, polls LY
+/// and STAT, plays with the timer and halts until the next interrupt.
+/// The VBlank and STAT handlers scroll, switch LCDC and palettes, and
+/// modify VRAM and OAM.
+auto BuildTestROM(unsigned int seed) -> std::vector<std::uint8_t>;
+
+/// Boot ROM that does nothing but disable itself, leaving PC at 0x100.
+auto BuildTestBootROM() -> std::vector<std::uint8_t>;
+
+auto WriteFile(std::string const& path, std::vector<std::uint8_t> const& data) -> bool;